@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstddef>
+#include <new>
+
+//=== AlignedAllocator class ===//
+//Allocator for std::vector that starts the storage on an Alignment byte boundary (cache line aligned texels), not final, containers derive from their allocator
+template <typename T, size_t Alignment>
+class AlignedAllocator
+{
+public:
+	typedef T value_type;
+	template <typename U>
+	struct rebind
+	{
+		typedef AlignedAllocator<U, Alignment> other;
+	};
+
+	//=== Constructors ===//
+	AlignedAllocator() = default;
+	template <typename U>
+	AlignedAllocator(const AlignedAllocator<U, Alignment>&) {}
+
+	//=== Functions ===//
+	T* allocate(size_t amount) { return static_cast<T*>(::operator new(amount * sizeof(T), std::align_val_t{ Alignment })); }
+	void deallocate(T* pMemory, size_t) { ::operator delete(pMemory, std::align_val_t{ Alignment }); }
+
+	template <typename U>
+	bool operator==(const AlignedAllocator<U, Alignment>&) const { return true; }
+	template <typename U>
+	bool operator!=(const AlignedAllocator<U, Alignment>&) const { return false; }
+};
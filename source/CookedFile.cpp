@@ -0,0 +1,188 @@
+#include "pch.h"
+
+#include <atomic>
+#include <filesystem>
+#include <random>
+
+#include "CookedFile.h"
+
+//=== Helpers ===//
+namespace
+{
+	//Unique per write, next to the cooked file so the rename stays on one volume
+	std::string GetTempPath(const std::string& cookedPath)
+	{
+		static std::atomic<uint32_t> s_AmountWrites{};
+		return cookedPath + "." + std::to_string(std::random_device{}()) + "_" + std::to_string(s_AmountWrites++) + ".tmp";
+	}
+}
+
+//=== Functions ===//
+int64_t Elite::GetSourceTime(const std::string& filePath)
+{
+	std::error_code error{};
+	const std::filesystem::file_time_type time{ std::filesystem::last_write_time(filePath, error) };
+	return error ? 0 : int64_t(time.time_since_epoch().count());
+}
+
+bool Elite::IsCookedCurrent(const CookedHeader& header, uint32_t magic, uint32_t version, int64_t sourceTime, const std::string& sourcePath,
+	const uint8_t* pData, size_t dataSize, size_t headerSize)
+{
+	return header.magic == magic && header.version == version && header.sourceTime == sourceTime && header.sourcePathSize == sourcePath.size()
+		&& IsCookedRange(headerSize, header.sourcePathSize, 1, dataSize)
+		&& sourcePath.compare(0, sourcePath.size(), reinterpret_cast<const char*>(pData + headerSize), header.sourcePathSize) == 0;
+}
+
+//=== Constructor ===//
+CookedWriter::CookedWriter(const std::string& cookedPath)
+	: m_CookedPath{ cookedPath }
+	, m_TempPath{ GetTempPath(cookedPath) }
+	, m_File{ m_TempPath, std::ios::binary | std::ios::trunc }
+	, m_pSections{}
+	, m_IsCommitted{}
+{
+}
+
+//=== Destructor ===//
+CookedWriter::~CookedWriter()
+{
+	//Sections are already gone after a commit
+	std::error_code error{};
+	for (const std::unique_ptr<Section>& pSection : m_pSections)
+	{
+		pSection->file.close();
+		std::filesystem::remove(pSection->path, error);
+	}
+
+	if (!m_IsCommitted)
+	{
+		m_File.close();
+		std::filesystem::remove(m_TempPath, error);
+	}
+}
+
+//=== Functions ===//
+void CookedWriter::Write(const void* pData, size_t size)
+{
+	m_File.write(static_cast<const char*>(pData), std::streamsize(size));
+}
+
+void CookedWriter::WriteAt(size_t position, const void* pData, size_t size)
+{
+	const std::streampos end{ m_File.tellp() };
+	m_File.seekp(std::streamoff(position));
+	m_File.write(static_cast<const char*>(pData), std::streamsize(size));
+	m_File.seekp(end);
+}
+
+void CookedWriter::PadTo(size_t position)
+{
+	static const char padding[Elite::cookedAlignment]{};
+	const std::streamoff current{ m_File.tellp() };
+	size_t amountPadding{ (current >= 0 && position > size_t(current)) ? position - size_t(current) : 0 };
+	while (m_File && amountPadding > 0)
+	{
+		const size_t amountWritten{ std::min(amountPadding, sizeof(padding)) };
+		m_File.write(padding, std::streamsize(amountWritten));
+		amountPadding -= amountWritten;
+	}
+}
+
+size_t CookedWriter::GetSize()
+{
+	const std::streamoff current{ m_File.tellp() };
+	return (current >= 0) ? size_t(current) : 0;
+}
+
+uint32_t CookedWriter::AddSection(bool isAligned)
+{
+	std::unique_ptr<Section> pSection{ std::make_unique<Section>() };
+	pSection->path = m_TempPath + "." + std::to_string(m_pSections.size());
+	pSection->file.open(pSection->path, std::ios::binary | std::ios::trunc);
+	pSection->size = 0;
+	pSection->isAligned = isAligned;
+	m_pSections.push_back(std::move(pSection));
+	return uint32_t(m_pSections.size() - 1);
+}
+
+void CookedWriter::WriteSection(uint32_t section, const void* pData, size_t size)
+{
+	Section& target{ *m_pSections[section] };
+	target.file.write(static_cast<const char*>(pData), std::streamsize(size));
+	target.size += size;
+}
+
+bool CookedWriter::ReadSection(uint32_t section, size_t position, void* pData, size_t size)
+{
+	Section& source{ *m_pSections[section] };
+	source.file.flush();
+	if (!source.file || position > source.size || size > source.size - position)
+	{
+		return false;
+	}
+
+	std::ifstream file{ source.path, std::ios::binary };
+	file.seekg(std::streamoff(position));
+	file.read(static_cast<char*>(pData), std::streamsize(size));
+	return size_t(file.gcount()) == size;
+}
+
+size_t CookedWriter::GetSectionOffset(uint32_t section)
+{
+	size_t offset{ GetSize() };
+	for (uint32_t i{}; i <= section; ++i)
+	{
+		offset = m_pSections[i]->isAligned ? Elite::AlignCooked(offset) : offset;
+		offset += (i < section) ? m_pSections[i]->size : 0;
+	}
+	return offset;
+}
+
+bool CookedWriter::Commit()
+{
+	//Sections are copied in blocks and removed right after, so the disk only holds them twice for one section at a time
+	bool isAppended{ true };
+	for (const std::unique_ptr<Section>& pSection : m_pSections)
+	{
+		isAppended = isAppended && AppendSection(*pSection);
+		std::error_code error{};
+		std::filesystem::remove(pSection->path, error);
+	}
+	m_pSections.clear();
+
+	m_File.close();
+	if (!m_File || !isAppended)
+	{
+		return false;
+	}
+
+	std::error_code error{};
+	std::filesystem::rename(m_TempPath, m_CookedPath, error);
+	m_IsCommitted = !error;
+	return m_IsCommitted;
+}
+
+bool CookedWriter::AppendSection(Section& section)
+{
+	section.file.close();
+	if (!section.file)
+	{
+		return false;
+	}
+	if (section.isAligned)
+	{
+		PadTo(Elite::AlignCooked(GetSize()));
+	}
+
+	std::ifstream file{ section.path, std::ios::binary };
+	std::vector<char> block(size_t(1) << 20);
+	size_t amountLeft{ section.size };
+	while (file && m_File && amountLeft > 0)
+	{
+		const size_t amountRead{ std::min(amountLeft, block.size()) };
+		file.read(block.data(), std::streamsize(amountRead));
+		m_File.write(block.data(), file.gcount());
+		amountLeft -= size_t(file.gcount());
+	}
+	return amountLeft == 0 && m_File;
+}
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <string>
+#include <fstream>
+#include <memory>
+#include <vector>
+
+//=== Cooked files ===//
+//Binary caches next to their source (<path>.cooked): a cache specific header that starts with a CookedHeader, the source path,
+//then data blocks that start on a cache line so they can be used straight out of a MappedFile
+constexpr uint32_t MakeFourCC(char a, char b, char c, char d)
+{
+	return uint32_t(uint8_t(a)) | (uint32_t(uint8_t(b)) << 8) | (uint32_t(uint8_t(c)) << 16) | (uint32_t(uint8_t(d)) << 24);
+}
+
+//=== CookedHeader struct ===//
+//First member of every cache header, the source path follows the whole cache header
+struct CookedHeader
+{
+	uint32_t magic;
+	uint32_t version;
+	int64_t sourceTime;
+	uint32_t sourcePathSize;
+};
+
+namespace Elite
+{
+	//=== Functions ===//
+	const size_t cookedAlignment{ 64 };
+	inline size_t AlignCooked(size_t offset) { return (offset + cookedAlignment - 1) / cookedAlignment * cookedAlignment; }
+
+	//Last write time of the source, the cooked file is stale as soon as it differs (0 when unknown)
+	int64_t GetSourceTime(const std::string& filePath);
+
+	//Magic, version, source time and source path of a mapped cooked file, headerSize is the size of the whole cache header
+	bool IsCookedCurrent(const CookedHeader& header, uint32_t magic, uint32_t version, int64_t sourceTime, const std::string& sourcePath,
+		const uint8_t* pData, size_t dataSize, size_t headerSize);
+
+	//amount elements of elementSize at offset lie inside the file, compared against what is left after offset so values read from the file can't wrap around
+	inline bool IsCookedRange(uint64_t offset, uint64_t amount, size_t elementSize, size_t dataSize)
+	{
+		return offset <= dataSize && amount <= (dataSize - offset) / elementSize;
+	}
+}
+
+//=== CookedWriter class ===//
+//Writes to a unique temporary file next to the cooked file and only renames it over the cooked file in Commit,
+//readers never map a half written file and concurrent writers (threads or processes cooking the same source) never interleave
+//Sections are streams of unknown size written next to each other (indices per material), each goes to its own temporary file
+//and they are appended to the file in order of creation at Commit
+class CookedWriter final
+{
+public:
+	//=== Constructor ===//
+	CookedWriter(const std::string& cookedPath);
+
+	//=== Rule of five ===//
+	~CookedWriter(); //Removes the temporary file when it wasn't committed
+	CookedWriter(const CookedWriter& cookedWriter) = delete;
+	CookedWriter(CookedWriter&& cookedWriter) = delete;
+	CookedWriter& operator=(const CookedWriter& cookedWriter) = delete;
+	CookedWriter& operator=(CookedWriter&& cookedWriter) = delete;
+
+	//=== Functions ===//
+	void Write(const void* pData, size_t size);
+	//Overwrites bytes that were already written (a header that is only known at the end)
+	void WriteAt(size_t position, const void* pData, size_t size);
+	//Zero bytes up to position (an offset from the start of the file)
+	void PadTo(size_t position);
+	size_t GetSize();
+
+	//An aligned section starts on a cache line, an unaligned one right after the previous section (continues its array)
+	uint32_t AddSection(bool isAligned);
+	void WriteSection(uint32_t section, const void* pData, size_t size);
+	//Reads back what was written to the section (to derive a stream that needs the whole section first), false when it isn't there
+	bool ReadSection(uint32_t section, size_t position, void* pData, size_t size);
+	//Where the section starts in the committed file, final once nothing is written to the file or the sections anymore
+	size_t GetSectionOffset(uint32_t section);
+
+	//False when anything failed, the old cooked file (if any) stays then
+	bool Commit();
+
+private:
+	//=== Section struct ===//
+	struct Section
+	{
+		std::string path;
+		std::ofstream file;
+		size_t size;
+		bool isAligned;
+	};
+
+	//=== Functions ===//
+	bool AppendSection(Section& section);
+
+	//=== Variables ===//
+	std::string m_CookedPath;
+	std::string m_TempPath;
+	std::ofstream m_File;
+	std::vector<std::unique_ptr<Section>> m_pSections;
+	bool m_IsCommitted;
+};
@@ -0,0 +1,477 @@
+#include "pch.h"
+
+#include <charconv>
+#include <chrono>
+#include <cctype>
+#include <cstring>
+#include <functional>
+#include <unordered_map>
+
+#include "EOBJParser.h"
+#include "MappedFile.h"
+#include "Tangents.h"
+#include "ThreadPool.h"
+
+//=== Helpers ===//
+namespace
+{
+	//One face corner as written in the file (1-based, 0 when missing)
+	//Negative indices are stored relative to the start of their chunk until the chunk is merged
+	struct ObjCorner
+	{
+		int32_t position;
+		int32_t uv;
+		int32_t normal;
+		uint32_t relative; //RelativeFlags of the indices that still need the chunk base
+
+		bool operator==(const ObjCorner& other) const { return position == other.position && uv == other.uv && normal == other.normal; }
+	};
+
+	//Vertices are welded on the index triple, equal triples are the same vertex
+	struct ObjCornerHash
+	{
+		size_t operator()(const ObjCorner& corner) const
+		{
+			uint64_t hash{ uint64_t(uint32_t(corner.position)) * 0x9E3779B97F4A7C15ull };
+			hash = (hash ^ uint32_t(corner.uv)) * 0xC2B2AE3D27D4EB4Full;
+			hash = (hash ^ uint32_t(corner.normal)) * 0x165667B19E3779F9ull;
+			return size_t(hash ^ (hash >> 29));
+		}
+	};
+
+	enum RelativeFlags : uint32_t
+	{
+		RelativePosition = 1 << 0,
+		RelativeUV = 1 << 1,
+		RelativeNormal = 1 << 2,
+	};
+
+	//usemtl inside a chunk, applies from firstCorner on (and to the chunks after it)
+	struct ObjMaterialRun
+	{
+		size_t firstCorner;
+		std::string material;
+	};
+
+	//Everything one chunk of lines produced, merged in file order afterwards
+	struct ObjChunk
+	{
+		const char* pBegin;
+		const char* pEnd;
+		std::vector<Elite::FPoint3> positions;
+		std::vector<Elite::FVector3> normals;
+		std::vector<Elite::FVector2> UVs;
+		std::vector<ObjCorner> corners; //3 per triangle, polygons are already triangulated
+		std::vector<ObjMaterialRun> materialRuns;
+	};
+
+	//Vertices welded since the last flush, with the indices (numbered within the segment) of every material that used them
+	struct ObjSegment
+	{
+		std::vector<ObjCorner> uniqueCorners;
+		std::unordered_map<ObjCorner, uint32_t, ObjCornerHash> cornerToVertex;
+		std::vector<std::vector<uint32_t>> materialIndices;
+		size_t amountIndices;
+	};
+
+	//Chunks are only worth the scheduling above the minimum size, the maximum bounds the parse buffers of a window
+	const size_t g_MinChunkSize{ 256 * 1024 };
+	const size_t g_MaxChunkSize{ 4 * 1024 * 1024 };
+	const size_t g_ChunksPerThread{ 2 }; //Per window
+
+	//A segment is flushed after the chunk that fills it, so it holds at most this plus one chunk
+	const size_t g_MaxSegmentVertices{ 1024 * 1024 };
+	const size_t g_MaxSegmentIndices{ 6 * 1024 * 1024 };
+
+	//=== Scanner ===//
+	//Never crosses a line end, a missing number reads as 0 and leaves the cursor where it was
+	inline void SkipSpaces(const char*& pCurrent, const char* pEnd)
+	{
+		while (pCurrent < pEnd && (*pCurrent == ' ' || *pCurrent == '\t' || *pCurrent == '\r'))
+		{
+			++pCurrent;
+		}
+	}
+
+	inline float ReadFloat(const char*& pCurrent, const char* pEnd)
+	{
+		SkipSpaces(pCurrent, pEnd);
+		if (pCurrent < pEnd && *pCurrent == '+')
+		{
+			++pCurrent;
+		}
+
+		float value{};
+		const std::from_chars_result result{ std::from_chars(pCurrent, pEnd, value) };
+		if (result.ec == std::errc{})
+		{
+			pCurrent = result.ptr;
+		}
+		return value;
+	}
+
+	inline int32_t ReadInt(const char*& pCurrent, const char* pEnd)
+	{
+		SkipSpaces(pCurrent, pEnd);
+
+		int32_t value{};
+		const std::from_chars_result result{ std::from_chars(pCurrent, pEnd, value) };
+		if (result.ec == std::errc{})
+		{
+			pCurrent = result.ptr;
+		}
+		return value;
+	}
+
+	inline const char* NextLine(const char* pCurrent, const char* pEnd)
+	{
+		const void* pNewLine{ std::memchr(pCurrent, '\n', size_t(pEnd - pCurrent)) };
+		return pNewLine ? static_cast<const char*>(pNewLine) + 1 : pEnd;
+	}
+
+	//Keyword followed by a space or tab, the cursor is moved past it
+	inline bool ReadKeyword(const char*& pCurrent, const char* pEnd, const char* keyword)
+	{
+		const size_t length{ std::strlen(keyword) };
+		if (size_t(pEnd - pCurrent) <= length || std::memcmp(pCurrent, keyword, length) != 0 || (pCurrent[length] != ' ' && pCurrent[length] != '\t'))
+		{
+			return false;
+		}
+
+		pCurrent += length;
+		return true;
+	}
+
+	//Negative indices count back from the last attribute so far, within the chunk that is amountLocal
+	inline int32_t ReadIndex(const char*& pCurrent, const char* pEnd, size_t amountLocal, uint32_t relativeFlag, uint32_t& relative)
+	{
+		const int32_t index{ ReadInt(pCurrent, pEnd) };
+		if (index >= 0)
+		{
+			return index;
+		}
+
+		relative |= relativeFlag;
+		return int32_t(amountLocal) + index + 1;
+	}
+
+	//Rest of the line without the surrounding spaces
+	inline std::string ReadName(const char* pCurrent, const char* pEnd)
+	{
+		SkipSpaces(pCurrent, pEnd);
+		const char* pNameEnd{ NextLine(pCurrent, pEnd) };
+		while (pNameEnd > pCurrent && std::isspace(static_cast<unsigned char>(pNameEnd[-1])))
+		{
+			--pNameEnd;
+		}
+		return std::string(pCurrent, pNameEnd);
+	}
+
+	//One corner (position/uv/normal, uv and normal optional), false when there is no corner left on the line
+	inline bool ReadCorner(const char*& pCurrent, const char* pEnd, const ObjChunk& chunk, ObjCorner& corner)
+	{
+		SkipSpaces(pCurrent, pEnd);
+		const char* pStart{ pCurrent };
+
+		corner = ObjCorner{};
+		corner.position = ReadIndex(pCurrent, pEnd, chunk.positions.size(), RelativePosition, corner.relative);
+		if (pCurrent == pStart)
+		{
+			return false;
+		}
+
+		if (pCurrent < pEnd && *pCurrent == '/')
+		{
+			++pCurrent;
+			if (pCurrent < pEnd && *pCurrent != '/')
+			{
+				corner.uv = ReadIndex(pCurrent, pEnd, chunk.UVs.size(), RelativeUV, corner.relative);
+			}
+			if (pCurrent < pEnd && *pCurrent == '/')
+			{
+				++pCurrent;
+				corner.normal = ReadIndex(pCurrent, pEnd, chunk.normals.size(), RelativeNormal, corner.relative);
+			}
+		}
+		return true;
+	}
+
+	void ParseChunk(ObjChunk& chunk)
+	{
+		const char* pEnd{ chunk.pEnd };
+		for (const char* pLine{ chunk.pBegin }; pLine < pEnd; pLine = NextLine(pLine, pEnd))
+		{
+			const char* pCurrent{ pLine };
+			SkipSpaces(pCurrent, pEnd);
+
+			if (ReadKeyword(pCurrent, pEnd, "v"))
+			{
+				//Vertex
+				const float x{ ReadFloat(pCurrent, pEnd) };
+				const float y{ ReadFloat(pCurrent, pEnd) };
+				const float z{ ReadFloat(pCurrent, pEnd) };
+				chunk.positions.push_back(Elite::FPoint3(x, y, z));
+			}
+			else if (ReadKeyword(pCurrent, pEnd, "vt"))
+			{
+				// Vertex TexCoord
+				const float u{ ReadFloat(pCurrent, pEnd) };
+				const float v{ ReadFloat(pCurrent, pEnd) };
+				chunk.UVs.push_back(Elite::FVector2(u, 1 - v));
+			}
+			else if (ReadKeyword(pCurrent, pEnd, "vn"))
+			{
+				// Vertex Normal
+				const float x{ ReadFloat(pCurrent, pEnd) };
+				const float y{ ReadFloat(pCurrent, pEnd) };
+				const float z{ ReadFloat(pCurrent, pEnd) };
+				chunk.normals.push_back(Elite::FVector3(x, y, z));
+			}
+			else if (ReadKeyword(pCurrent, pEnd, "f"))
+			{
+				// Faces, polygons are triangulated as a fan around the first corner
+				ObjCorner first{}, previous{}, corner{};
+				for (size_t amountCorners{}; ReadCorner(pCurrent, pEnd, chunk, corner); ++amountCorners)
+				{
+					if (amountCorners == 0)
+					{
+						first = corner;
+					}
+					else if (amountCorners >= 2)
+					{
+						chunk.corners.push_back(first);
+						chunk.corners.push_back(previous);
+						chunk.corners.push_back(corner);
+					}
+					previous = corner;
+				}
+			}
+			else if (ReadKeyword(pCurrent, pEnd, "usemtl"))
+			{
+				// Material of the faces that follow
+				chunk.materialRuns.push_back(ObjMaterialRun{ chunk.corners.size(), ReadName(pCurrent, pEnd) });
+			}
+			//Objects and groups (o, g), material libraries (mtllib), smoothing groups (s), comments and everything else are skipped,
+			//submeshes are split on material only
+		}
+	}
+
+	//OBJ format uses 1-based arrays, out of range indices leave the attribute at its default
+	template <typename Attribute>
+	inline void Resolve(const std::vector<Attribute>& attributes, int32_t index, Attribute& attribute)
+	{
+		if (index > 0 && size_t(index) <= attributes.size())
+		{
+			attribute = attributes[size_t(index) - 1];
+		}
+	}
+}
+
+//=== Functions ===//
+bool Elite::ParseOBJ(const std::string& filename, const ObjOutput& output, std::vector<SubMesh>& subMeshes, ThreadPool* pThreadPool)
+{
+	const auto start{ std::chrono::high_resolution_clock::now() };
+
+	MappedFile file{};
+	if (!file.Open(filename))
+		return false;
+
+	subMeshes.clear();
+
+	//Runs on the pool when there is one
+	const auto parallelFor = [pThreadPool](uint32_t amountJobs, const std::function<void(uint32_t)>& job)
+	{
+		if (pThreadPool)
+		{
+			pThreadPool->ParallelFor(amountJobs, job);
+			return;
+		}
+		for (uint32_t i{}; i < amountJobs; ++i)
+		{
+			job(i);
+		}
+	};
+
+	//Line aligned chunks, a few per thread so uneven chunks even out, parsed one window at a time
+	const char* pData{ reinterpret_cast<const char*>(file.GetData()) };
+	const char* pDataEnd{ pData + file.GetSize() };
+	const size_t amountThreads{ pThreadPool ? pThreadPool->GetAmountThreads() : 1 };
+	const size_t chunkSize{ std::clamp(file.GetSize() / (amountThreads * 4) + 1, g_MinChunkSize, g_MaxChunkSize) };
+	std::vector<ObjChunk> window(amountThreads * g_ChunksPerThread);
+
+	std::vector<FPoint3> positions;
+	std::vector<FVector3> normals;
+	std::vector<FVector2> UVs;
+
+	//A material only gets an ID (and a submesh) once a face uses it
+	std::unordered_map<std::string, uint32_t> materialToID{};
+	std::string currentMaterial{};
+	uint32_t currentMaterialID{ UINT32_MAX };
+
+	//Corners with the same position/uv/normal triple are welded into one vertex, in file order so the result is deterministic
+	ObjSegment segment{};
+	std::vector<Vertex> vertices{};
+	std::vector<uint32_t> segmentIndices{};
+	size_t amountVertices{};
+	size_t amountIndices{};
+	size_t amountSegments{};
+
+	//Constructs the vertices of the segment (split in ranges over the pool), their tangents from the triangles of every material,
+	//and hands both to output, only the buffers (bounded by the segment size) are kept for the next one
+	const auto flushSegment = [&]()
+	{
+		const size_t amountSegmentVertices{ segment.uniqueCorners.size() };
+		vertices.assign(amountSegmentVertices, Vertex{});
+		const uint32_t amountRanges{ uint32_t(std::min(amountThreads * 4, amountSegmentVertices)) };
+		parallelFor(amountRanges, [&](uint32_t range)
+			{
+				const size_t begin{ amountSegmentVertices * range / amountRanges };
+				const size_t end{ amountSegmentVertices * (range + 1) / amountRanges };
+				for (size_t index{ begin }; index < end; ++index)
+				{
+					const ObjCorner& corner{ segment.uniqueCorners[index] };
+
+					FPoint3 position{};
+					Resolve(positions, corner.position, position);
+					vertices[index].position = FPoint4{ position };
+					Resolve(UVs, corner.uv, vertices[index].uv);
+					Resolve(normals, corner.normal, vertices[index].normal);
+				}
+			});
+
+		segmentIndices.clear();
+		for (const std::vector<uint32_t>& materialList : segment.materialIndices)
+		{
+			segmentIndices.insert(segmentIndices.end(), materialList.begin(), materialList.end());
+		}
+		GenerateTangents(vertices.data(), vertices.size(), segmentIndices.data(), segmentIndices.size(), pThreadPool);
+		output.addVertices(vertices.data(), vertices.size());
+
+		//Numbered over all vertices so far from here on
+		for (uint32_t materialID{}; materialID < segment.materialIndices.size(); ++materialID)
+		{
+			std::vector<uint32_t>& materialList{ segment.materialIndices[materialID] };
+			if (materialList.empty())
+			{
+				continue;
+			}
+
+			for (uint32_t& index : materialList)
+			{
+				index += uint32_t(amountVertices);
+			}
+			output.addIndices(materialID, materialList.data(), materialList.size());
+			subMeshes[materialID].amountIndices += uint32_t(materialList.size());
+			std::vector<uint32_t>{}.swap(materialList);
+		}
+
+		amountVertices += amountSegmentVertices;
+		amountIndices += segment.amountIndices;
+		++amountSegments;
+		segment.uniqueCorners.clear();
+		segment.cornerToVertex.clear();
+		segment.amountIndices = 0;
+	};
+
+	size_t amountChunks{};
+	for (const char* pWindowBegin{ pData }; pWindowBegin < pDataEnd;)
+	{
+		//Fill the window, chunk buffers keep their capacity between windows
+		uint32_t amountWindowChunks{};
+		for (; amountWindowChunks < window.size() && pWindowBegin < pDataEnd; ++amountWindowChunks)
+		{
+			ObjChunk& chunk{ window[amountWindowChunks] };
+			chunk.pBegin = pWindowBegin;
+			chunk.pEnd = (size_t(pDataEnd - pWindowBegin) > chunkSize) ? NextLine(pWindowBegin + chunkSize, pDataEnd) : pDataEnd;
+			chunk.positions.clear();
+			chunk.normals.clear();
+			chunk.UVs.clear();
+			chunk.corners.clear();
+			chunk.materialRuns.clear();
+			pWindowBegin = chunk.pEnd;
+		}
+		amountChunks += amountWindowChunks;
+
+		parallelFor(amountWindowChunks, [&window](uint32_t chunk) { ParseChunk(window[chunk]); });
+
+		//Merge in file order
+		for (uint32_t i{}; i < amountWindowChunks; ++i)
+		{
+			ObjChunk& chunk{ window[i] };
+			const int32_t positionBase{ int32_t(positions.size()) };
+			const int32_t UVBase{ int32_t(UVs.size()) };
+			const int32_t normalBase{ int32_t(normals.size()) };
+			positions.insert(positions.end(), chunk.positions.begin(), chunk.positions.end());
+			normals.insert(normals.end(), chunk.normals.begin(), chunk.normals.end());
+			UVs.insert(UVs.end(), chunk.UVs.begin(), chunk.UVs.end());
+
+			size_t run{};
+			for (size_t corner{}; corner < chunk.corners.size(); corner += 3)
+			{
+				for (; run < chunk.materialRuns.size() && chunk.materialRuns[run].firstCorner <= corner; ++run)
+				{
+					currentMaterial = std::move(chunk.materialRuns[run].material);
+					currentMaterialID = UINT32_MAX;
+				}
+				if (currentMaterialID == UINT32_MAX)
+				{
+					const auto result{ materialToID.emplace(currentMaterial, uint32_t(subMeshes.size())) };
+					if (result.second)
+					{
+						subMeshes.push_back(SubMesh{ currentMaterial, 0, 0 });
+						segment.materialIndices.emplace_back();
+					}
+					currentMaterialID = result.first->second;
+				}
+
+				for (size_t j{ corner }; j < corner + 3; ++j)
+				{
+					ObjCorner objCorner{ chunk.corners[j] };
+					objCorner.position += (objCorner.relative & RelativePosition) ? positionBase : 0;
+					objCorner.uv += (objCorner.relative & RelativeUV) ? UVBase : 0;
+					objCorner.normal += (objCorner.relative & RelativeNormal) ? normalBase : 0;
+					objCorner.relative = 0;
+
+					const auto result{ segment.cornerToVertex.emplace(objCorner, uint32_t(segment.uniqueCorners.size())) };
+					if (result.second)
+					{
+						segment.uniqueCorners.push_back(objCorner);
+					}
+					segment.materialIndices[currentMaterialID].push_back(result.first->second);
+				}
+				segment.amountIndices += 3;
+			}
+
+			//usemtl after the last face of the chunk still applies to the next chunk
+			for (; run < chunk.materialRuns.size(); ++run)
+			{
+				currentMaterial = std::move(chunk.materialRuns[run].material);
+				currentMaterialID = UINT32_MAX;
+			}
+
+			if (segment.uniqueCorners.size() >= g_MaxSegmentVertices || segment.amountIndices >= g_MaxSegmentIndices)
+			{
+				flushSegment();
+			}
+		}
+	}
+	if (!segment.uniqueCorners.empty())
+	{
+		flushSegment();
+	}
+
+	//Submeshes follow each other in order of first use
+	uint32_t firstIndex{};
+	for (SubMesh& subMesh : subMeshes)
+	{
+		subMesh.firstIndex = firstIndex;
+		firstIndex += subMesh.amountIndices;
+	}
+
+	const std::chrono::duration<double> seconds{ std::chrono::high_resolution_clock::now() - start };
+	const double megabytes{ double(file.GetSize()) / (1024.0 * 1024.0) };
+	std::cout << filename << ": " << megabytes << " MB parsed in " << seconds.count() * 1000.0 << " ms (" << megabytes / seconds.count() << " MB/s, "
+		<< amountChunks << " chunks, " << amountSegments << " segments, " << amountVertices << " vertices for " << amountIndices << " indices, " << subMeshes.size() << " submeshes)" << std::endl;
+
+	return true;
+}
@@ -1,9 +1,10 @@
 #include "pch.h"
 
 #include <iostream>
+#include <fstream>
+#include <chrono>
 
 #include "ERenderer.h"
-#include "EOBJParser.h"
 
 #include "Vertex.h"
 #include "Material.h"
@@ -12,6 +13,9 @@
 #include "Texture.h"
 #include "Mesh.h"
 #include "Triangle.h"
+#include "ThreadPool.h"
+#include "RasterKernels.h"
+#include "TextureBenchmark.h"
 
 Elite::Renderer::Renderer(SDL_Window* pWindow)
 	: m_pWindow{ pWindow }
@@ -46,6 +50,20 @@ Elite::Renderer::Renderer(SDL_Window* pWindow)
 	//=== DepthBuffer ===//
 	m_pDepthBufferPixels = new float[size_t(m_Width) * size_t(m_Height)];
 
+	//=== Tiles + workers ===//
+	m_pThreadPool = std::make_unique<ThreadPool>();
+	m_AmountTilesX = (m_Width + m_TileSize - 1) / m_TileSize;
+	m_AmountTilesY = (m_Height + m_TileSize - 1) / m_TileSize;
+	m_TileBins.resize(size_t(m_AmountTilesX) * size_t(m_AmountTilesY));
+
+	//=== Hierarchical Z ===//
+	m_AmountHiZBlocksX = m_AmountTilesX * (m_TileSize / m_HiZBlockSize);
+	m_HiZBlocks.resize(size_t(m_AmountHiZBlocksX) * size_t(m_AmountTilesY * (m_TileSize / m_HiZBlockSize)));
+	m_HiZTiles.resize(m_TileBins.size());
+
+	//=== VisibilityBuffer ===//
+	m_VisibilityBuffer.resize(size_t(m_Width) * size_t(m_Height));
+
 	//=== Mesh ===//
 	InitVehicle();
 	//--------------------------------------------------------------------------------------------------------------------------------------------//
@@ -73,44 +91,84 @@ void Elite::Renderer::Render()
 void Elite::Renderer::InitVehicle()
 {
 	//- Main Mesh -//
-	//Initialize textures
-	m_pTexture = new Texture{ "Resources/vehicle_diffuse.png", m_pDevice };
-	m_pNormal = new Texture{ "Resources/vehicle_normal.png", m_pDevice };
-	m_pSpecular = new Texture{ "Resources/vehicle_specular.png", m_pDevice };
-	m_pGloss = new Texture{ "Resources/vehicle_gloss.png", m_pDevice };
+	//Initialize textures (block compressed .dds next to the .png is preferred, the .png when the .dds can't be loaded, e.g. an unsupported format)
+	const auto loadTexture = [](const std::string& name)
+	{
+		const std::string ddsPath{ "Resources/" + name + ".dds" };
+		if (std::ifstream{ ddsPath }.good())
+		{
+			Texture* pTexture{ new Texture{ ddsPath } };
+			if (pTexture->GetAmountMipLevels() > 0)
+			{
+				return pTexture;
+			}
+			delete pTexture;
+		}
+		return new Texture{ "Resources/" + name + ".png" };
+	};
+	const std::pair<std::string, Texture**> textureJobs[]{
+		{ "vehicle_diffuse", &m_pTexture },
+		{ "vehicle_normal", &m_pNormal },
+		{ "vehicle_specular", &m_pSpecular },
+		{ "vehicle_gloss", &m_pGloss },
+		{ "fireFX_diffuse", &m_pFireDiffuse },
+	};
+
+	//Decode all of them at once on the pool (one texture per job), ParallelFor joins before anything uses them
+	const auto loadStart{ std::chrono::high_resolution_clock::now() };
+	m_pThreadPool->ParallelFor(uint32_t(std::size(textureJobs)), [&textureJobs, &loadTexture](uint32_t job)
+		{
+			*textureJobs[job].second = loadTexture(textureJobs[job].first);
+		});
 
-	//Initialize materials
-	m_pVehicleEffect = new TexturedMaterial(m_pDevice, L"Resources/LambertPhongShader.fx", "LambertPhongImprovedTechnique");
+	//Uploads stay on this thread, it owns the device
+	for (const std::pair<std::string, Texture**>& textureJob : textureJobs)
+	{
+		(*textureJob.second)->CreateHardwareTexture(m_pDevice);
+	}
+	const std::chrono::duration<double, std::milli> loadTime{ std::chrono::high_resolution_clock::now() - loadStart };
+	std::cout << std::size(textureJobs) << " textures loaded in " << loadTime.count() << " ms" << std::endl;
+
+	//Interleaving would decompress block compressed maps, those are sampled one by one instead
+	bool isDecoded{ true };
+	for (Texture* pTexture : { m_pTexture, m_pNormal, m_pSpecular, m_pGloss })
+	{
+		isDecoded &= (pTexture->GetFormat() == Texture::TexelFormat::RGBA8);
+	}
+	if (isDecoded)
+	{
+		m_pMaterialTexture = new Texture{ *m_pTexture, m_pNormal, m_pSpecular, m_pGloss };
 
-	//Parse object
-	std::vector<Vertex> vertices{};
-	std::vector<uint32_t> indices{};
+		//Already uploaded, the hardware keeps sampling the separate maps, software only reads the interleaved copy
+		for (Texture* pTexture : { m_pTexture, m_pNormal, m_pSpecular, m_pGloss })
+		{
+			pTexture->ReleaseTexels();
+		}
+	}
+
+	//Initialize materials
+	const Mesh::VertexFormat vertexFormat{ m_IsPackedVertices ? Mesh::VertexFormat::Packed : Mesh::VertexFormat::Full };
+	m_pVehicleEffect = new TexturedMaterial(m_pDevice, L"Resources/LambertPhongShader.fx", m_IsPackedVertices ? "LambertPhongImprovedPackedTechnique" : "LambertPhongImprovedTechnique");
 
-	Elite::ParseOBJ("Resources/vehicle.obj", vertices, indices);
+	//Parse object (cooked binary on later runs)
+	m_VehicleMeshCache.Load("Resources/vehicle.obj", m_pThreadPool.get());
 
 	//Push object for software rendering
-	m_pSoftwareMeshes.push_back(new Mesh{ vertices, indices, Mesh::PrimitiveTopology::TriangleList });
-	for (Mesh* pMesh : m_pSoftwareMeshes) for (Triangle* pTriangle : pMesh->GetTriangles()) m_pTriangles.push_back(pTriangle);
+	m_pSoftwareMeshes.push_back(new Mesh{ m_VehicleMeshCache, Mesh::PrimitiveTopology::TriangleList, vertexFormat });
 
-	//Push object for hardware rendering (change z-pos -> left handed coordinate system)
-	for (Vertex& vertex : vertices) { vertex.position.z *= -1; vertex.normal.z *= -1; vertex.tangent.z *= -1; } //Invert z (left handed coordinate system)
-	m_pHardwareMeshes.push_back(new Mesh{ m_pDevice, vertices, indices, m_pVehicleEffect, m_pTexture, m_pNormal, m_pSpecular, m_pGloss });
+	//Push object for hardware rendering (z is inverted in the world matrix when rendering -> left handed coordinate system)
+	m_pHardwareMeshes.push_back(new Mesh{ m_pDevice, m_VehicleMeshCache, m_pVehicleEffect, vertexFormat, m_pTexture, m_pNormal, m_pSpecular, m_pGloss });
 
 	//- Fire Mesh -//
-	//Initialize textures
-	m_pFireDiffuse = new Texture{ "Resources/fireFX_diffuse.png", m_pDevice };
-
 	//Initialize materials
 	m_pFireEffect = new DiffuseMaterial(m_pDevice, L"Resources/AlphaShader.fx", "FilterTechnique");
 
-	//Parse object
-	std::vector<Vertex> verticesFire{};
-	std::vector<uint32_t> indicesFire{};
-
-	Elite::ParseOBJ("Resources/fireFX.obj", verticesFire, indicesFire);
+	//Parse object, hardware only so it is only needed until it is uploaded
+	MeshCache fireMeshCache{};
+	fireMeshCache.Load("Resources/fireFX.obj", m_pThreadPool.get());
 
 	//Push object for rendering (separate for toggle)
-	m_pFireMesh = new Mesh{ m_pDevice, verticesFire, indicesFire, m_pFireEffect, m_pFireDiffuse };
+	m_pFireMesh = new Mesh{ m_pDevice, fireMeshCache, m_pFireEffect, Mesh::VertexFormat::Full, m_pFireDiffuse };
 }
 
 HRESULT Elite::Renderer::InitializeDirectX()
@@ -222,19 +280,89 @@ void Elite::Renderer::RenderSoftware()
 	SDL_LockSurface(m_pBackBuffer);
 
 	//------------------------------------------------------------------------------------------------------------------------------------------//
-	//=== Fill depthbuffer and backbuffer ===//
-	std::fill(m_pDepthBufferPixels, m_pDepthBufferPixels + size_t(m_Width) * size_t(m_Height), FLT_MAX);
-	std::fill(m_pBackBufferPixels, m_pBackBufferPixels + size_t(m_Width) * size_t(m_Height), GetSDL_ARGBColor(Elite::RGBColor(0.1f, 0.1f, 0.1f)));
+	//If no rotation is needed make elapsed time zero so the object doesn't move
+	if (!m_IsRotating) m_ElapsedTime = 0.f;
+
+	//=== Frame constants -> matrices that are the same for every vertex, computed once ===//
+	UpdateFrameConstants();
+
+	//=== Projection stage -> positions only, every vertex once into the post-transform streams of its mesh ===//
+	for (Mesh* pMesh : m_pSoftwareMeshes)
+	{
+		ProjectionStage(pMesh, m_FrameConstants);
+	}
+
+	//=== Triangle setup -> cull and prepare triangles in submission order, only positions are read so far ===//
+	m_ClippedStreams.Clear();
+	m_ClippedTriangles.clear();
+	m_DeferredClips.clear();
+	m_TriangleSetups.clear();
+	for (Mesh* pMesh : m_pSoftwareMeshes)
+	{
+		for (Triangle* pTriangle : pMesh->GetTriangles())
+		{
+			//Frustum culling check
+			if (FrustumCulling(pTriangle))
+			{
+				//Skip whole triangle if triangle is out of frame
+				continue;
+			}
+
+			//Clipping interpolates attributes, so it waits for the attribute stage (remembering where its setups go)
+			if (pTriangle->GetClipPlanes(m_FrameConstants) != 0)
+			{
+				m_DeferredClips.push_back(DeferredClip{ pTriangle, uint32_t(m_TriangleSetups.size()) });
+				pMesh->UseVertices(pTriangle);
+				continue;
+			}
+
+			//Edge functions and bounding box, once per triangle
+			TriangleSetup setup{};
+			if (TriangleSetupStage(pTriangle, setup, m_FrameConstants))
+			{
+				m_TriangleSetups.push_back(setup);
+				pMesh->UseVertices(pTriangle);
+			}
+		}
+	}
+
+	//=== Attribute stage -> normals, tangents and view directions, only for vertices of triangles that are still there ===//
+	for (Mesh* pMesh : m_pSoftwareMeshes)
+	{
+		AttributeStage(pMesh, m_FrameConstants);
+	}
 
-	//=== Loop over triangles ===//
-	for (Triangle* pTriangle : m_pTriangles)
+	//=== Clipping stage -> the triangles of a clipped polygon are set up in place of the original triangle ===//
+	if (!m_DeferredClips.empty())
 	{
-		//=== Projection stage -> transforming vertices ===//
-		ProjectionStage(pTriangle, m_pCamera->GetViewToWorld(), m_pCamera->GetFov(), m_Width, m_Height, m_pCamera->GetPosition());
+		m_UnclippedSetups.swap(m_TriangleSetups);
+		m_TriangleSetups.clear();
 
-		//=== Rasterization stage + PixelShading stage -> calculating correct values to sample a pixel color ===//
-		RasterizationStage(pTriangle, m_Width, m_Height, m_pDepthBufferPixels);
+		size_t nextSetup{};
+		for (const DeferredClip& deferredClip : m_DeferredClips)
+		{
+			m_TriangleSetups.insert(m_TriangleSetups.end(), m_UnclippedSetups.begin() + nextSetup, m_UnclippedSetups.begin() + deferredClip.setupIndex);
+			nextSetup = deferredClip.setupIndex;
+
+			const size_t firstClipped{ m_ClippedTriangles.size() };
+			ClippingStage(deferredClip.pTriangle, m_FrameConstants);
+			for (size_t i{ firstClipped }; i < m_ClippedTriangles.size(); ++i)
+			{
+				TriangleSetup setup{};
+				if (TriangleSetupStage(&m_ClippedTriangles[i], setup, m_FrameConstants))
+				{
+					m_TriangleSetups.push_back(setup);
+				}
+			}
+		}
+		m_TriangleSetups.insert(m_TriangleSetups.end(), m_UnclippedSetups.begin() + nextSetup, m_UnclippedSetups.end());
 	}
+
+	//=== Binning stage -> sort triangles into the tiles they touch ===//
+	BinningStage();
+
+	//=== Rasterization stage + PixelShading stage -> every worker owns whole tiles ===//
+	m_pThreadPool->ParallelFor(uint32_t(m_TileBins.size()), [this](uint32_t tileIndex) { RasterizeTile(tileIndex); });
 	//------------------------------------------------------------------------------------------------------------------------------------------//
 
 	SDL_UnlockSurface(m_pBackBuffer);
@@ -242,104 +370,340 @@ void Elite::Renderer::RenderSoftware()
 	SDL_UpdateWindowSurface(m_pWindow);
 }
 
-void Elite::Renderer::ProjectionStage(Triangle* pTriangle, const Elite::FMatrix4& cameraToWorld, float fovAngle, uint32_t width, uint32_t height, const Elite::FPoint3& cameraPos)
+void Elite::Renderer::UpdateFrameConstants()
 {
-	//If no rotation is needed make elapsed time zero so the object doesn't move
-	if (!m_IsRotating) m_ElapsedTime = 0.f;
+	//Calculate aspect ratio for camera view
+	const float aspectRatio{ float(m_Width) / float(m_Height) }, nearPlane{ 0.1f }, farPlane{ 100.f };
+	const float fov{ m_pCamera->GetFov() };
+
+	FrameConstants& constants{ m_FrameConstants };
+	constants.viewMatrix = m_pCamera->GetWorldToView();
+	constants.projectionMatrix = { 1 / (aspectRatio * fov),	0,			0,									0,
+									0,							1 / fov,	0,									0,
+									0,							0,			-farPlane / (farPlane - nearPlane),	-(farPlane * nearPlane) / (farPlane - nearPlane),
+									0,							0,			-1,									0 };
+	constants.viewProjectionMatrix = constants.projectionMatrix * constants.viewMatrix;
+
+	constants.worldMatrix = m_WorldMatrix;
+	constants.worldViewProjectionMatrix = constants.viewProjectionMatrix * m_WorldMatrix;
+	constants.normalMatrix = Transpose(Inverse(FMatrix3{ m_WorldMatrix }));
+
+	constants.cameraPosition = m_pCamera->GetPosition();
+
+	constants.width = m_Width;
+	constants.height = m_Height;
+
+	//Guard band, 1000 pixels from the screen center keeps the 28.4 edge values of the rasterizer in 32 bits
+	const float guardBandPixels{ 1000.f };
+	constants.guardBandX = std::max(guardBandPixels / (m_Width * 0.5f), 1.f);
+	constants.guardBandY = std::max(guardBandPixels / (m_Height * 0.5f), 1.f);
+}
 
-	//First part of vertex transformation
-	ModelToWorld(pTriangle, cameraPos, m_ElapsedTime);
+void Elite::Renderer::ProjectionStage(Mesh* pMesh, const FrameConstants& constants)
+{
+	//Every vertex is independent, so chunks of vertices can be transformed in parallel
+	const size_t chunkSize{ 1024 };
+	const size_t amountVertices{ pMesh->GetAmountVertices() };
+	const uint32_t amountChunks{ uint32_t((amountVertices + chunkSize - 1) / chunkSize) };
 
-	//Second part of vertex transformation
-	ModelToNDC(pTriangle, cameraToWorld, fovAngle, width, height);
+	m_pThreadPool->ParallelFor(amountChunks, [&](uint32_t chunk)
+		{
+			const size_t begin{ chunk * chunkSize };
+			const size_t end{ std::min(begin + chunkSize, amountVertices) };
+
+			//First part of vertex transformation
+			ModelToNDC(pMesh, begin, end, constants);
+
+			//Second part of vertex transformation
+			NDCToScreen(pMesh, begin, end, constants);
+		});
+}
+
+void Elite::Renderer::AttributeStage(Mesh* pMesh, const FrameConstants& constants)
+{
+	//Same chunks as the projection stage, vertices nothing uses are skipped inside
+	const size_t chunkSize{ 1024 };
+	const size_t amountVertices{ pMesh->GetAmountVertices() };
+	const uint32_t amountChunks{ uint32_t((amountVertices + chunkSize - 1) / chunkSize) };
+
+	m_pThreadPool->ParallelFor(amountChunks, [&](uint32_t chunk)
+		{
+			const size_t begin{ chunk * chunkSize };
+			const size_t end{ std::min(begin + chunkSize, amountVertices) };
+
+			//Last part of vertex transformation
+			TransformAttributes(pMesh, begin, end, constants);
+		});
 }
 
-void Elite::Renderer::ModelToWorld(Triangle* pTriangle, const Elite::FPoint3& cameraPos, float elapsedTime)
+void Elite::Renderer::TransformAttributes(Mesh* pMesh, size_t begin, size_t end, const FrameConstants& constants)
+{
+	//Last part of vertex transformation (attributes of used vertices)
+	pMesh->TransformAttributes(begin, end, constants);
+}
+
+void Elite::Renderer::ModelToNDC(Mesh* pMesh, size_t begin, size_t end, const FrameConstants& constants)
 {
 	//First part of vertex transformation
-	pTriangle->ModelToWorld(cameraPos, m_WorldMatrix);
+	pMesh->ModelToNDC(begin, end, constants);
 }
 
-void Elite::Renderer::ModelToNDC(Triangle* pTriangle, const Elite::FMatrix4& cameraToWorld, float fovAngle, uint32_t width, uint32_t height)
+void Elite::Renderer::BinningStage()
 {
-	//Second part of vertex transformation
-	pTriangle->ModelToNDC(cameraToWorld, fovAngle, width, height);
+	for (std::vector<uint32_t>& bin : m_TileBins)
+	{
+		bin.clear();
+	}
+
+	//Push the triangle in every tile its bounding box overlaps, bins keep the submission order
+	for (uint32_t i{}; i < uint32_t(m_TriangleSetups.size()); ++i)
+	{
+		const TriangleSetup& setup{ m_TriangleSetups[i] };
+		for (uint32_t tileY{ setup.minY / m_TileSize }; tileY <= (setup.maxY - 1) / m_TileSize; ++tileY)
+		{
+			for (uint32_t tileX{ setup.minX / m_TileSize }; tileX <= (setup.maxX - 1) / m_TileSize; ++tileX)
+			{
+				m_TileBins[tileX + tileY * m_AmountTilesX].push_back(i);
+			}
+		}
+	}
 }
 
-void Elite::Renderer::RasterizationStage(Triangle* pTriangle, uint32_t width, uint32_t height, float* depthBuffer)
+void Elite::Renderer::RasterizeTile(uint32_t tileIndex)
 {
-	//Frustum culling check
-	if (FrustumCulling(pTriangle))
+	//Tile bounds, max is exclusive
+	const uint32_t tileMinX{ (tileIndex % m_AmountTilesX) * m_TileSize };
+	const uint32_t tileMinY{ (tileIndex / m_AmountTilesX) * m_TileSize };
+	const uint32_t tileMaxX{ std::min(tileMinX + m_TileSize, m_Width) };
+	const uint32_t tileMaxY{ std::min(tileMinY + m_TileSize, m_Height) };
+
+	//=== Fill depthbuffer and backbuffer ===//
+	const uint32_t clearColor{ GetSDL_ARGBColor(Elite::RGBColor(0.1f, 0.1f, 0.1f)) };
+	for (uint32_t r = tileMinY; r < tileMaxY; ++r)
+	{
+		std::fill(m_pDepthBufferPixels + tileMinX + size_t(r) * m_Width, m_pDepthBufferPixels + tileMaxX + size_t(r) * m_Width, FLT_MAX);
+		std::fill(m_pBackBufferPixels + tileMinX + size_t(r) * m_Width, m_pBackBufferPixels + tileMaxX + size_t(r) * m_Width, clearColor);
+
+		if (m_IsVisibilityBuffer)
+		{
+			std::fill(m_VisibilityBuffer.begin() + tileMinX + size_t(r) * m_Width, m_VisibilityBuffer.begin() + tileMaxX + size_t(r) * m_Width,
+				VisibilityPixel{ VisibilityPixel::invalidIndex, 0.f, 0.f, 0.f });
+		}
+	}
+
+	//Nothing drawn yet, so nothing can be hidden
+	for (uint32_t blockY{ tileMinY }; blockY < tileMaxY; blockY += m_HiZBlockSize)
 	{
-		//Skip whole triangle if triangle is out of frame
-		return;
+		for (uint32_t blockX{ tileMinX }; blockX < tileMaxX; blockX += m_HiZBlockSize)
+		{
+			m_HiZBlocks[blockX / m_HiZBlockSize + (blockY / m_HiZBlockSize) * m_AmountHiZBlocksX] = FLT_MAX;
+		}
 	}
+	float& tileMaxDepth{ m_HiZTiles[tileIndex] };
+	tileMaxDepth = FLT_MAX;
+
+	//=== Loop over triangles of this tile ===//
+	for (uint32_t setupIndex : m_TileBins[tileIndex])
+	{
+		//Whole triangle is behind everything already drawn in this tile
+		if (m_IsHierarchicalZ && m_TriangleSetups[setupIndex].minZ >= tileMaxDepth)
+		{
+			continue;
+		}
 
-	//Third part of vertex transformation
-	NDCToScreen(pTriangle, width, height);
+		//Coarse level is the max of the blocks of this tile, only changes when one of them got closer
+		if (!RasterizationStage(setupIndex, tileMinX, tileMinY, tileMaxX, tileMaxY, m_pDepthBufferPixels))
+		{
+			continue;
+		}
+
+		tileMaxDepth = 0.f;
+		for (uint32_t blockY{ tileMinY }; blockY < tileMaxY; blockY += m_HiZBlockSize)
+		{
+			for (uint32_t blockX{ tileMinX }; blockX < tileMaxX; blockX += m_HiZBlockSize)
+			{
+				tileMaxDepth = std::max(tileMaxDepth, m_HiZBlocks[blockX / m_HiZBlockSize + (blockY / m_HiZBlockSize) * m_AmountHiZBlocksX]);
+			}
+		}
+	}
 
-	//Calculate bounding box
-	std::vector<Elite::FPoint2> boundingBox = pTriangle->GetBoundingBox(float(width), float(height));
+	//=== Shade every covered pixel of this tile once ===//
+	if (m_IsVisibilityBuffer)
+	{
+		ShadingPass(tileMinX, tileMinY, tileMaxX, tileMaxY);
+	}
+}
 
-	//Loop over pixels in bounding box
-	for (uint32_t r = uint32_t(boundingBox[0].y); r < uint32_t(boundingBox[1].y); ++r)
+bool Elite::Renderer::RasterizationStage(uint32_t setupIndex, uint32_t tileMinX, uint32_t tileMinY, uint32_t tileMaxX, uint32_t tileMaxY, float* depthBuffer)
+{
+	const TriangleSetup& setup{ m_TriangleSetups[setupIndex] };
+	const SpanKernel rasterizeSpan{ GetSpanKernel(m_RasterKernel) };
+
+	//Only walk the part of the bounding box inside this tile
+	const uint32_t minX{ std::max(setup.minX, tileMinX) };
+	const uint32_t minY{ std::max(setup.minY, tileMinY) };
+	const uint32_t maxX{ std::min(setup.maxX, tileMaxX) };
+	const uint32_t maxY{ std::min(setup.maxY, tileMaxY) };
+
+	const EdgeFunction& edge0{ setup.edges[0] };
+	const EdgeFunction& edge1{ setup.edges[1] };
+	const EdgeFunction& edge2{ setup.edges[2] };
+
+	//Walk the bounding box per hierarchical Z block, a block row is exactly one span
+	static_assert(m_HiZBlockSize <= PixelBatch::size, "A block row has to fit in one span");
+	PixelBatch batch{};
+	bool isHiZLowered{ false };
+	for (uint32_t blockY{ minY / m_HiZBlockSize * m_HiZBlockSize }; blockY < maxY; blockY += m_HiZBlockSize)
 	{
-		for (uint32_t c = uint32_t(boundingBox[0].x); c < uint32_t(boundingBox[1].x); ++c)
+		for (uint32_t blockX{ minX / m_HiZBlockSize * m_HiZBlockSize }; blockX < maxX; blockX += m_HiZBlockSize)
 		{
-			//Initialize current pixel and weights
-			const Elite::FPoint2 pixel{ (float)c, (float)r };
-			float weight0{}, weight1{}, weight2{};
+			float& blockMaxDepth{ m_HiZBlocks[blockX / m_HiZBlockSize + (blockY / m_HiZBlockSize) * m_AmountHiZBlocksX] };
 
-			//Pixel in triangle (hit) check
-			if (PixelInTriangle(pTriangle, pixel, weight0, weight1, weight2))
+			//Whole block is behind what is already drawn
+			if (m_IsHierarchicalZ && setup.minZ >= blockMaxDepth)
 			{
-				//Initialize wInterpolated
-				float wInterpolated{};
+				continue;
+			}
+
+			const uint32_t spanMinX{ std::max(blockX, minX) };
+			const uint32_t spanMaxX{ std::min(blockX + m_HiZBlockSize, maxX) };
+			const uint32_t rowMinY{ std::max(blockY, minY) };
+			const uint32_t rowMaxY{ std::min(blockY + m_HiZBlockSize, maxY) };
+
+			//Edge values at the center of the top left pixel of the block, from here on they are only stepped
+			const int32_t centerX{ int32_t(spanMinX) * EdgeFunction::subPixelScale + EdgeFunction::subPixelScale / 2 };
+			const int32_t centerY{ int32_t(rowMinY) * EdgeFunction::subPixelScale + EdgeFunction::subPixelScale / 2 };
+			int32_t rowEdges[3]{ int32_t(edge0.Evaluate(centerX, centerY)), int32_t(edge1.Evaluate(centerX, centerY)), int32_t(edge2.Evaluate(centerX, centerY)) };
 
-				//Depth check and calculation
-				if (Depth(pTriangle, depthBuffer[c + (r * width)], wInterpolated, weight0, weight1, weight2))
+			bool isDepthWritten{ false };
+			for (uint32_t r = rowMinY; r < rowMaxY; ++r)
+			{
+				//Coverage + depth test for the whole span
+				const uint32_t c{ spanMinX };
+				uint32_t mask{ rasterizeSpan(setup, rowEdges, spanMaxX - spanMinX, depthBuffer + c + size_t(r) * m_Width, batch) };
+				isDepthWritten |= mask != 0;
+
+				//Shade the pixels that passed, or only remember them in visibility buffer mode
+				while (mask)
 				{
-					//Depth buffer toggle
-					if (!m_IsDepthBufferColor)
+					const uint32_t i{ LowestBitIndex(mask) };
+					mask &= mask - 1;
+
+					if (m_IsVisibilityBuffer)
 					{
-						//Initialize interpolated values
-						Elite::FVector2 uvInterpolated{};
-						Elite::FVector3 normalInterpolated{};
-						Elite::FVector3 tangentInterpolated{};
-						Elite::FVector3 viewDirectionInterpolated{};
-						Elite::RGBColor colorInterpolated{};
-
-						//Attribute interpolation
-						AttributeInterpolation(pTriangle, wInterpolated, weight0, weight1, weight2, uvInterpolated, normalInterpolated, tangentInterpolated, viewDirectionInterpolated, colorInterpolated);
-
-						//Calculate final color
-						Elite::RGBColor finalColor = PixelShadingStage(uvInterpolated, normalInterpolated, tangentInterpolated, viewDirectionInterpolated, colorInterpolated);
-						finalColor.MaxToOne();
-
-						//Draw on back buffer
-						uint32_t uColor{ GetSDL_ARGBColor(finalColor) };
-						m_pBackBufferPixels[c + (r * m_Width)] = SDL_MapRGB(m_pBackBuffer->format,
-							static_cast<uint8_t>(uColor >> 16),
-							static_cast<uint8_t>(uColor >> 8),
-							static_cast<uint8_t>(uColor));
+						m_VisibilityBuffer[c + i + size_t(r) * m_Width] = { setupIndex, batch.weight0[i], batch.weight1[i], batch.wInterpolated[i] };
 					}
 					else
 					{
-						//Calculate depth color
-						float depth{ Elite::Remap(m_pDepthBufferPixels[c + (r * m_Width)], 1.f, 0.985f) };
-						Elite::RGBColor depthColor{ depth, depth, depth };
-						depthColor.MaxToOne();
-
-						//Draw on back buffer
-						uint32_t uColor{ GetSDL_ARGBColor(depthColor) };
-						m_pBackBufferPixels[c + (r * m_Width)] = SDL_MapRGB(m_pBackBuffer->format,
-							static_cast<uint8_t>(uColor >> 16),
-							static_cast<uint8_t>(uColor >> 8),
-							static_cast<uint8_t>(uColor));
+						PixelStage(setup, c + i, r, batch.weight0[i], batch.weight1[i], batch.weight2[i], batch.wInterpolated[i]);
 					}
 				}
+
+				rowEdges[0] += edge0.b * EdgeFunction::subPixelScale;
+				rowEdges[1] += edge1.b * EdgeFunction::subPixelScale;
+				rowEdges[2] += edge2.b * EdgeFunction::subPixelScale;
+			}
+
+			//Depth only gets closer, so the block max only has to be refreshed when something was written
+			if (isDepthWritten)
+			{
+				const float newMaxDepth{ BlockMaxDepth(blockX, blockY, depthBuffer) };
+				isHiZLowered |= newMaxDepth < blockMaxDepth;
+				blockMaxDepth = newMaxDepth;
+			}
+		}
+	}
+
+	return isHiZLowered;
+}
+
+float Elite::Renderer::BlockMaxDepth(uint32_t blockX, uint32_t blockY, const float* depthBuffer) const
+{
+	//Blocks at the right and bottom of the screen can be partial
+	const uint32_t maxX{ std::min(blockX + m_HiZBlockSize, m_Width) };
+	const uint32_t maxY{ std::min(blockY + m_HiZBlockSize, m_Height) };
+
+	float maxDepth{ 0.f };
+	for (uint32_t r = blockY; r < maxY; ++r)
+	{
+		for (uint32_t c = blockX; c < maxX; ++c)
+		{
+			maxDepth = std::max(maxDepth, depthBuffer[c + size_t(r) * m_Width]);
+		}
+	}
+
+	return maxDepth;
+}
+
+void Elite::Renderer::ShadingPass(uint32_t tileMinX, uint32_t tileMinY, uint32_t tileMaxX, uint32_t tileMaxY)
+{
+	//Only the closest triangle of every pixel is left in the visibility buffer, so every pixel is shaded at most once
+	for (uint32_t r = tileMinY; r < tileMaxY; ++r)
+	{
+		for (uint32_t c = tileMinX; c < tileMaxX; ++c)
+		{
+			const VisibilityPixel& pixel{ m_VisibilityBuffer[c + size_t(r) * m_Width] };
+			if (pixel.setupIndex == VisibilityPixel::invalidIndex)
+			{
+				continue;
 			}
+
+			PixelStage(m_TriangleSetups[pixel.setupIndex], c, r, pixel.weight0, pixel.weight1, 1.f - pixel.weight0 - pixel.weight1, pixel.wInterpolated);
+		}
+	}
+}
+
+void Elite::Renderer::PixelStage(const TriangleSetup& setup, uint32_t c, uint32_t r, const float weight0, const float weight1, const float weight2, const float wInterpolated)
+{
+	Triangle* pTriangle{ setup.pTriangle };
+
+	//Depth buffer toggle
+	if (!m_IsDepthBufferColor)
+	{
+		//Initialize interpolated values
+		Elite::FVector2 uvInterpolated{};
+		Elite::FVector3 normalInterpolated{};
+		Elite::FVector3 tangentInterpolated{};
+		Elite::FVector3 viewDirectionInterpolated{};
+		Elite::RGBColor colorInterpolated{};
+
+		//Attribute interpolation
+		AttributeInterpolation(pTriangle, wInterpolated, weight0, weight1, weight2, uvInterpolated, normalInterpolated, tangentInterpolated, viewDirectionInterpolated, colorInterpolated);
+
+		//UV derivatives from the 2x2 pixel quad, only needed to pick a mip level and the anisotropic footprint
+		Elite::FVector2 uvDdx{}, uvDdy{};
+		if (m_pTexture && (m_MipFilter != Texture::MipFilter::None || m_Filter == Mesh::Filter::Anisotropic))
+		{
+			pTriangle->UVDerivatives(setup, c, r, uvDdx, uvDdy);
 		}
+
+		//Handedness is constant over a triangle, taken from the first vertex
+		const float tangentSign{ pTriangle->GetAttributes(0).tangentSign };
+
+		//Calculate final color
+		Elite::RGBColor finalColor = PixelShadingStage(uvInterpolated, uvDdx, uvDdy, normalInterpolated, tangentInterpolated, tangentSign, viewDirectionInterpolated, colorInterpolated);
+		finalColor.MaxToOne();
+
+		//Draw on back buffer
+		uint32_t uColor{ GetSDL_ARGBColor(finalColor) };
+		m_pBackBufferPixels[c + (r * m_Width)] = SDL_MapRGB(m_pBackBuffer->format,
+			static_cast<uint8_t>(uColor >> 16),
+			static_cast<uint8_t>(uColor >> 8),
+			static_cast<uint8_t>(uColor));
+	}
+	else
+	{
+		//Calculate depth color
+		float depth{ Elite::Remap(m_pDepthBufferPixels[c + (r * m_Width)], 1.f, 0.985f) };
+		Elite::RGBColor depthColor{ depth, depth, depth };
+		depthColor.MaxToOne();
+
+		//Draw on back buffer
+		uint32_t uColor{ GetSDL_ARGBColor(depthColor) };
+		m_pBackBufferPixels[c + (r * m_Width)] = SDL_MapRGB(m_pBackBuffer->format,
+			static_cast<uint8_t>(uColor >> 16),
+			static_cast<uint8_t>(uColor >> 8),
+			static_cast<uint8_t>(uColor));
 	}
 }
 
@@ -349,16 +713,37 @@ bool Elite::Renderer::FrustumCulling(Triangle* pTriangle)
 	return pTriangle->FrustumCulling();
 }
 
-void Elite::Renderer::NDCToScreen(Triangle* pTriangle, uint32_t width, uint32_t height)
+bool Elite::Renderer::ClippingStage(Triangle* pTriangle, const FrameConstants& constants)
+{
+	//Only near/far and triangles leaving the guard band need clipping, everything else goes to setup untouched
+	const uint32_t clipPlanes{ pTriangle->GetClipPlanes(constants) };
+	if (clipPlanes == 0)
+	{
+		return false;
+	}
+
+	//Triangulate the clipped polygon as a fan
+	const uint32_t firstVertex{ uint32_t(m_ClippedStreams.clipPositions.size()) };
+	const uint32_t amountVertices{ pTriangle->Clip(clipPlanes, constants, m_ClippedStreams) };
+	for (uint32_t i{ 1 }; i + 1 < amountVertices; ++i)
+	{
+		m_ClippedTriangles.emplace_back(m_ClippedStreams, firstVertex, firstVertex + i, firstVertex + i + 1);
+	}
+
+	return true;
+}
+
+void Elite::Renderer::NDCToScreen(Mesh* pMesh, size_t begin, size_t end, const FrameConstants& constants)
 {
-	//Third part of vertex transformation
-	pTriangle->NDCToScreen(width, height);
+	//Second part of vertex transformation
+	pMesh->NDCToScreen(begin, end, constants);
 }
 
-bool Elite::Renderer::PixelInTriangle(Triangle* pTriangle, const Elite::FPoint2& pixel, float& weight0, float& weight1, float& weight2)
+bool Elite::Renderer::TriangleSetupStage(Triangle* pTriangle, TriangleSetup& setup, const FrameConstants& constants)
 {
-	//Pixel in triangle check
-	return pTriangle->PixelInTriangle(pixel, weight0, weight1, weight2, m_CullMode);
+	//Per triangle setup (edge functions, culling, bounding box), the span kernels and the pixel stage reach the triangle through it
+	setup.pTriangle = pTriangle;
+	return pTriangle->Setup(setup, m_CullMode, constants.width, constants.height);
 }
 
 bool Elite::Renderer::Depth(Triangle* pTriangle, float& depthBufferPixel, float& wInterpolated, const float weight0, const float weight1, const float weight2)
@@ -374,12 +759,15 @@ void Elite::Renderer::AttributeInterpolation(Triangle* pTriangle, const float wI
 	pTriangle->AttributeInterpolation(pTriangle, wInterpolated, weight0, weight1, weight2, uvInterpolated, normalInterpolated, tangentInterpolated, viewDirectionInterpolated, colorInterpolated);
 }
 
-Elite::RGBColor Elite::Renderer::PixelShadingStage(const Elite::FVector2& uvInterpolated, const Elite::FVector3& normalInterpolated, const Elite::FVector3& tangentInterpolated,
-	const Elite::FVector3& viewDirectionInterpolated, const Elite::RGBColor& colorInterpolated)
+Elite::RGBColor Elite::Renderer::PixelShadingStage(const Elite::FVector2& uvInterpolated, const Elite::FVector2& uvDdx, const Elite::FVector2& uvDdy, const Elite::FVector3& normalInterpolated, const Elite::FVector3& tangentInterpolated,
+	float tangentSign, const Elite::FVector3& viewDirectionInterpolated, const Elite::RGBColor& colorInterpolated)
 {
 	//Implementation with 'backwards compatibility' for colors and textures without normals etc.
 	if (m_pTexture)
 	{
+		//Sample all maps
+		const MaterialSample material{ SampleMaterial(uvInterpolated, uvDdx, uvDdy) };
+
 		//Initialize light
 		const Elite::FVector3 lightDirection{ Elite::GetNormalized(Elite::FVector3(0.577f, -0.577f, -0.577f)) };
 		const Elite::RGBColor lightColor{ 1.0f, 1.0f, 1.0f };
@@ -396,18 +784,18 @@ Elite::RGBColor Elite::Renderer::PixelShadingStage(const Elite::FVector2& uvInte
 			if (m_IsNormalMapping)
 			{
 				//Normal mapping and diffuse color
-				newNormal = NormalMapping(uvInterpolated, normalInterpolated, tangentInterpolated);
-				diffuseColor = Diffuse(uvInterpolated, newNormal, lightDirection, lightColor, lightIntensity);
+				newNormal = NormalMapping(material, normalInterpolated, tangentInterpolated, tangentSign);
+				diffuseColor = Diffuse(material, newNormal, lightDirection, lightColor, lightIntensity);
 			}
 			else
 			{
 				//Diffuse color
-				diffuseColor = Diffuse(uvInterpolated, normalInterpolated, lightDirection, lightColor, lightIntensity);
+				diffuseColor = Diffuse(material, normalInterpolated, lightDirection, lightColor, lightIntensity);
 			}
 		}
 		else
 		{
-			diffuseColor = m_pTexture->Sample(uvInterpolated);
+			diffuseColor = material.diffuse;
 		}
 
 		//Second stage of pixelshading
@@ -418,7 +806,7 @@ Elite::RGBColor Elite::Renderer::PixelShadingStage(const Elite::FVector2& uvInte
 			float specularReflectance{};
 
 			//Specular
-			const Elite::RGBColor specularColor = Specular(viewDirectionInterpolated, uvInterpolated, newNormal, -lightDirection, shininess, specularReflectance);
+			const Elite::RGBColor specularColor = Specular(viewDirectionInterpolated, material, newNormal, -lightDirection, shininess, specularReflectance);
 
 			return ambientColor + diffuseColor + specularColor;
 		}
@@ -430,37 +818,52 @@ Elite::RGBColor Elite::Renderer::PixelShadingStage(const Elite::FVector2& uvInte
 		return colorInterpolated;
 	}
 }
-Elite::FVector3 Elite::Renderer::NormalMapping(const Elite::FVector2& uvInterpolated, const Elite::FVector3& normalInterpolated, const Elite::FVector3& tangentInterpolated)
+MaterialSample Elite::Renderer::SampleMaterial(const Elite::FVector2& uvInterpolated, const Elite::FVector2& uvDdx, const Elite::FVector2& uvDdy)
 {
-	//Sample normals
-	const Elite::RGBColor normalMapSample = m_pNormal->Sample(uvInterpolated);
+	//Interleaved maps, one fetch
+	if (m_pMaterialTexture)
+	{
+		return m_pMaterialTexture->SampleMaterial(uvInterpolated, uvDdx, uvDdy, m_MipFilter, m_Filter);
+	}
 
+	//Separate (block compressed) maps, normal z is reconstructed the same way as in the interleaved texture
+	MaterialSample material{};
+	material.diffuse = m_pTexture->Sample(uvInterpolated, uvDdx, uvDdy, m_MipFilter, m_Filter);
+	if (m_pNormal)
+	{
+		const Elite::RGBColor normalMapSample{ m_pNormal->Sample(uvInterpolated, uvDdx, uvDdy, m_MipFilter, m_Filter) };
+		material.normal.x = 2.0f * normalMapSample.r - 1.0f;
+		material.normal.y = 2.0f * normalMapSample.g - 1.0f;
+		material.normal.z = sqrtf(std::max(1.0f - material.normal.x * material.normal.x - material.normal.y * material.normal.y, 0.0f));
+	}
+	if (m_pSpecular) material.specular = m_pSpecular->Sample(uvInterpolated, uvDdx, uvDdy, m_MipFilter, m_Filter).r;
+	if (m_pGloss) material.gloss = m_pGloss->Sample(uvInterpolated, uvDdx, uvDdy, m_MipFilter, m_Filter).r;
+	return material;
+}
+Elite::FVector3 Elite::Renderer::NormalMapping(const MaterialSample& material, const Elite::FVector3& normalInterpolated, const Elite::FVector3& tangentInterpolated, float tangentSign)
+{
 	//Calculate biNormal, tangentSpaceAxis and newNormal
-	const Elite::FVector3 biNormal{ Elite::Cross(tangentInterpolated, normalInterpolated) };
+	const Elite::FVector3 biNormal{ Elite::Cross(tangentInterpolated, normalInterpolated) * tangentSign };
 	const Elite::FMatrix3 tangentSpaceAxis{ tangentInterpolated, biNormal, normalInterpolated };
-	const Elite::FVector3 newNormal{ Elite::GetNormalized(tangentSpaceAxis * Elite::FVector3(2.0f * normalMapSample.r - 1.0f, 2.0f * normalMapSample.g - 1.0f, 2.0f * normalMapSample.b - 1.0f)) };
+	const Elite::FVector3 newNormal{ Elite::GetNormalized(tangentSpaceAxis * material.normal) };
 
 	return newNormal;
 }
-Elite::RGBColor Elite::Renderer::Diffuse(const Elite::FVector2& uvInterpolated, const Elite::FVector3& newNormal, const Elite::FVector3& lightDirection, const Elite::RGBColor& lightColor,
+Elite::RGBColor Elite::Renderer::Diffuse(const MaterialSample& material, const Elite::FVector3& newNormal, const Elite::FVector3& lightDirection, const Elite::RGBColor& lightColor,
 	const float lightIntensity)
 {
-	//Sample texture color
-	Elite::RGBColor diffuseMapSample = m_pTexture->Sample(uvInterpolated);
-
 	//Calculate irradiance with observedArea
 	const float observedArea{ std::max(Elite::Dot(newNormal, -lightDirection), 0.0f) };
 	const Elite::RGBColor irradiance{ lightColor * lightIntensity * observedArea };
 
-	return irradiance * (diffuseMapSample / float(E_PI));
+	return irradiance * (material.diffuse / float(E_PI));
 }
-Elite::RGBColor Elite::Renderer::Specular(const Elite::FVector3& viewDirectionInterpolated, const Elite::FVector2& uvInterpolated, const Elite::FVector3& newNormal, const Elite::FVector3& lightDirection,
+Elite::RGBColor Elite::Renderer::Specular(const Elite::FVector3& viewDirectionInterpolated, const MaterialSample& material, const Elite::FVector3& newNormal, const Elite::FVector3& lightDirection,
 	const float shininess, float& specularReflectance)
 {
-	//Sample glossiness
-	const Elite::RGBColor specularColor = m_pSpecular->Sample(uvInterpolated);
-	//Sample specular
-	const float phongExponent = m_pGloss->Sample(uvInterpolated).r * shininess;
+	//Specular is a greyscale map, gloss scales the exponent
+	const Elite::RGBColor specularColor{ material.specular, material.specular, material.specular };
+	const float phongExponent = material.gloss * shininess;
 
 	//Calculate reflection, angle and phong
 	const Elite::FVector3 reflect{ Elite::Reflect(-lightDirection, newNormal) };
@@ -488,10 +891,13 @@ void Elite::Renderer::RenderHardware()
 	const Elite::FMatrix4 viewMatrix{ m_pCamera->GetWorldToView() };
 	const Elite::FMatrix4 projectionMatrix{ m_pCamera->GetProjectionMatrix() };
 
+	//Vehicle vertices are right handed, mirror z before the world transform instead of in the (cached) vertex data
+	const Elite::FMatrix4 leftHandedWorldMatrix{ m_WorldMatrix * Elite::FMatrix4{ Elite::MakeScale(1.f, 1.f, -1.f) } };
+
 	//Render
 	for (Mesh* pMesh : m_pHardwareMeshes)
 	{
-		pMesh->Render(m_pDeviceContext, m_Filter, m_CullMode, m_WorldMatrix, viewMatrix, projectionMatrix);
+		pMesh->Render(m_pDeviceContext, m_Filter, m_CullMode, leftHandedWorldMatrix, viewMatrix, projectionMatrix);
 	}
 
 	if (m_ShowFireMesh)
@@ -581,31 +987,31 @@ void Elite::Renderer::InfoKeys(SDL_Scancode key)
 		}
 	}
 
-	if (!m_UsingSoftware)
+	//Toggle filter (hardware sampler states and software sampler)
+	if (key == SDL_SCANCODE_F)
 	{
-		//Toggle filter
-		if (key == SDL_SCANCODE_F)
+		if (m_Filter == Mesh::Filter::Point)
 		{
-			if (m_Filter == Mesh::Filter::Point)
-			{
-				m_Filter = Mesh::Filter::Linear;
+			m_Filter = Mesh::Filter::Linear;
 
-				std::cout << "Now linear filtering" << std::endl;
-			}
-			else if (m_Filter == Mesh::Filter::Linear)
-			{
-				m_Filter = Mesh::Filter::Anisotropic;
+			std::cout << "Now linear filtering" << std::endl;
+		}
+		else if (m_Filter == Mesh::Filter::Linear)
+		{
+			m_Filter = Mesh::Filter::Anisotropic;
 
-				std::cout << "Now anisotropic filtering" << std::endl;
-			}
-			else if (m_Filter == Mesh::Filter::Anisotropic)
-			{
-				m_Filter = Mesh::Filter::Point;
+			std::cout << "Now anisotropic filtering" << std::endl;
+		}
+		else if (m_Filter == Mesh::Filter::Anisotropic)
+		{
+			m_Filter = Mesh::Filter::Point;
 
-				std::cout << "Now point filtering" << std::endl;
-			}
+			std::cout << "Now point filtering" << std::endl;
 		}
+	}
 
+	if (!m_UsingSoftware)
+	{
 		//Toggle fire
 		if (key == SDL_SCANCODE_T)
 		{
@@ -615,6 +1021,78 @@ void Elite::Renderer::InfoKeys(SDL_Scancode key)
 	}
 	else
 	{
+		//Cycle rasterization kernel (scalar reference <-> SIMD), skipping what this CPU can't run
+		if (key == SDL_SCANCODE_K)
+		{
+			do
+			{
+				m_RasterKernel = static_cast<RasterKernel>((static_cast<int>(m_RasterKernel) + 1) % static_cast<int>(RasterKernel::Count));
+			} while (!IsRasterKernelSupported(m_RasterKernel));
+
+			std::cout << "Now " << GetRasterKernelName(m_RasterKernel) << " rasterization" << std::endl;
+		}
+
+		//Cycle mip filter
+		if (key == SDL_SCANCODE_M)
+		{
+			if (m_MipFilter == Texture::MipFilter::None)
+			{
+				m_MipFilter = Texture::MipFilter::Nearest;
+
+				std::cout << "Now nearest mip sampling" << std::endl;
+			}
+			else if (m_MipFilter == Texture::MipFilter::Nearest)
+			{
+				m_MipFilter = Texture::MipFilter::Trilinear;
+
+				std::cout << "Now trilinear sampling" << std::endl;
+			}
+			else if (m_MipFilter == Texture::MipFilter::Trilinear)
+			{
+				m_MipFilter = Texture::MipFilter::None;
+
+				std::cout << "Now no mip sampling" << std::endl;
+			}
+		}
+
+		//Toggle texel layout of the software textures
+		if (key == SDL_SCANCODE_L)
+		{
+			m_TexelLayout = (m_TexelLayout == Texture::TexelLayout::RowMajor) ? Texture::TexelLayout::Tiled : Texture::TexelLayout::RowMajor;
+			for (Texture* pTexture : { m_pTexture, m_pNormal, m_pSpecular, m_pGloss })
+			{
+				if (pTexture) pTexture->SetLayout(m_TexelLayout);
+			}
+			if (m_pMaterialTexture) m_pMaterialTexture->SetLayout(m_TexelLayout);
+
+			std::cout << ((m_TexelLayout == Texture::TexelLayout::Tiled) ? "Now tiled texel layout" : "Now row-major texel layout") << std::endl;
+		}
+
+		//Benchmark texel layouts and filters on the texture software shading reads
+		if (key == SDL_SCANCODE_B)
+		{
+			Texture* pSampled{ m_pMaterialTexture ? m_pMaterialTexture : m_pTexture };
+			if (pSampled)
+			{
+				BenchmarkTextureLayouts(*pSampled);
+				BenchmarkTextureFilters(*pSampled);
+			}
+		}
+
+		//Toggle hierarchical Z rejection
+		if (key == SDL_SCANCODE_H)
+		{
+			m_IsHierarchicalZ = !m_IsHierarchicalZ;
+			std::cout << "Hierarchical Z toggled" << std::endl;
+		}
+
+		//Toggle visibility buffer (deferred shading)
+		if (key == SDL_SCANCODE_V)
+		{
+			m_IsVisibilityBuffer = !m_IsVisibilityBuffer;
+			std::cout << "Visibility buffer toggled" << std::endl;
+		}
+
 		////Optional
 		//Toggle for depth buffer color view
 		if (key == SDL_SCANCODE_Z)
@@ -640,9 +1118,9 @@ void Elite::Renderer::InfoText()
 		"\t-Moving:\n\t    LMB + MouseMove - Y: Forward / Backward\n\t    LMB + RMB + MouseMove - Y: Up / Down\n" <<
 		"    KeyBoard:\n" <<
 		"\t-Moving:\n\t    W: Forward  /  S: Backward\n\t    A: Left  /  D: Right\n" <<
-		"\t-Rendering:\n\t    R: Toggle rotate\n\t    C: Toggle culling mode\n\t    E: Toggle system\n" <<
-		"\t    -Software only: \n\t\tZ: Toggle depth buffer\n" <<
-		"\t    -Hardware only: \n\t\tT: Toggle fire mesh\n\t\tF: Toggle filter" <<
+		"\t-Rendering:\n\t    R: Toggle rotate\n\t    C: Toggle culling mode\n\t    E: Toggle system\n\t    F: Toggle filter\n" <<
+		"\t    -Software only: \n\t\tZ: Toggle depth buffer\n\t\tK: Cycle rasterization kernel\n\t\tV: Toggle visibility buffer\n\t\tH: Toggle hierarchical Z\n\t\tM: Cycle mip filter\n\t\tL: Toggle texel layout\n\t\tB: Benchmark texel layouts and filters\n" <<
+		"\t    -Hardware only: \n\t\tT: Toggle fire mesh" <<
 		std::endl;
 }
 
@@ -658,6 +1136,8 @@ Elite::Renderer::~Renderer()
 	m_pSpecular = nullptr;
 	delete m_pGloss;
 	m_pGloss = nullptr;
+	delete m_pMaterialTexture;
+	m_pMaterialTexture = nullptr;
 
 	//- Software -//
 	//Meshes (triangles)
@@ -8,20 +8,25 @@
 #define	ELITE_RAYTRACING_RENDERER
 
 #include <cstdint>
+#include <deque>
 
 //-------------------------//
 #include <memory>
 #include <vector>
 
 #include "ECamera.h"
+#include "FrameConstants.h"
 #include "Vertex.h"
 #include "Mesh.h"
 #include "Triangle.h"
+#include "RasterKernels.h"
+#include "Texture.h"
+#include "MeshCache.h"
 
 class Material;
 class DiffuseMaterial;
 class TexturedMaterial;
-class Texture;
+class ThreadPool;
 //-------------------------//
 
 struct SDL_Window;
@@ -48,22 +53,32 @@ namespace Elite
 
 		//=== Software pipeline ===//
 		void RenderSoftware();
-		void ProjectionStage(Triangle* pTriangle, const Elite::FMatrix4& cameraToWorld, float fovAngle, uint32_t width, uint32_t height, const Elite::FPoint3& cameraPos);
-		void ModelToWorld(Triangle* pTriangle, const Elite::FPoint3& cameraPos, float elapsedTime);
-		void ModelToNDC(Triangle* pTriangle, const Elite::FMatrix4& cameraToWorld, float fovAngle, uint32_t width, uint32_t height);
-		void RasterizationStage(Triangle* pTriangle, uint32_t width, uint32_t height, float* depthBuffer);
+		void UpdateFrameConstants();
+		void ProjectionStage(Mesh* pMesh, const FrameConstants& constants);
+		void AttributeStage(Mesh* pMesh, const FrameConstants& constants);
+		void TransformAttributes(Mesh* pMesh, size_t begin, size_t end, const FrameConstants& constants);
+		void ModelToNDC(Mesh* pMesh, size_t begin, size_t end, const FrameConstants& constants);
+		void BinningStage();
+		void RasterizeTile(uint32_t tileIndex);
+		//Returns true when the max depth of a hierarchical Z block got closer, only then the tile max can change
+		bool RasterizationStage(uint32_t setupIndex, uint32_t tileMinX, uint32_t tileMinY, uint32_t tileMaxX, uint32_t tileMaxY, float* depthBuffer);
+		float BlockMaxDepth(uint32_t blockX, uint32_t blockY, const float* depthBuffer) const;
+		void ShadingPass(uint32_t tileMinX, uint32_t tileMinY, uint32_t tileMaxX, uint32_t tileMaxY);
+		void PixelStage(const TriangleSetup& setup, uint32_t c, uint32_t r, const float weight0, const float weight1, const float weight2, const float wInterpolated);
 		bool FrustumCulling(Triangle* pTriangle);
-		void NDCToScreen(Triangle* pTriangle, uint32_t width, uint32_t height);
-		bool PixelInTriangle(Triangle* pTriangle, const Elite::FPoint2& pixel, float& weight0, float& weight1, float& weight2);
+		bool ClippingStage(Triangle* pTriangle, const FrameConstants& constants);
+		void NDCToScreen(Mesh* pMesh, size_t begin, size_t end, const FrameConstants& constants);
+		bool TriangleSetupStage(Triangle* pTriangle, TriangleSetup& setup, const FrameConstants& constants);
 		bool Depth(Triangle* pTriangle, float& depthBufferPixel, float& wInterpolated, const float weight0, const float weight1, const float weight2);
 		void AttributeInterpolation(Triangle* pTriangle, const float wInterpolated, const float weight0, const float weight1, const float weight2, Elite::FVector2& uvInterpolated,
 			Elite::FVector3& normalInterpolated, Elite::FVector3& tangentInterpolated, Elite::FVector3& viewDirectionInterpolated, Elite::RGBColor& colorInterpolated);
-		Elite::RGBColor PixelShadingStage(const Elite::FVector2& uvInterpolated, const Elite::FVector3& normalInterpolated, const Elite::FVector3& tangentInterpolated,
-			const Elite::FVector3& viewDirectionInterpolated, const Elite::RGBColor& colorInterpolated);
-		Elite::FVector3 NormalMapping(const Elite::FVector2& uvInterpolated, const Elite::FVector3& normalInterpolated, const Elite::FVector3& tangentInterpolated);
-		Elite::RGBColor Diffuse(const Elite::FVector2& uvInterpolated, const Elite::FVector3& newNormal, const Elite::FVector3& lightDirection, const Elite::RGBColor& lightColor,
+		Elite::RGBColor PixelShadingStage(const Elite::FVector2& uvInterpolated, const Elite::FVector2& uvDdx, const Elite::FVector2& uvDdy, const Elite::FVector3& normalInterpolated, const Elite::FVector3& tangentInterpolated,
+			float tangentSign, const Elite::FVector3& viewDirectionInterpolated, const Elite::RGBColor& colorInterpolated);
+		MaterialSample SampleMaterial(const Elite::FVector2& uvInterpolated, const Elite::FVector2& uvDdx, const Elite::FVector2& uvDdy);
+		Elite::FVector3 NormalMapping(const MaterialSample& material, const Elite::FVector3& normalInterpolated, const Elite::FVector3& tangentInterpolated, float tangentSign);
+		Elite::RGBColor Diffuse(const MaterialSample& material, const Elite::FVector3& newNormal, const Elite::FVector3& lightDirection, const Elite::RGBColor& lightColor,
 			const float lightIntensity);
-		Elite::RGBColor Specular(const Elite::FVector3& viewDirectionInterpolated, const Elite::FVector2& uvInterpolated, const Elite::FVector3& newNormal, const Elite::FVector3& lightDirection,
+		Elite::RGBColor Specular(const Elite::FVector3& viewDirectionInterpolated, const MaterialSample& material, const Elite::FVector3& newNormal, const Elite::FVector3& lightDirection,
 			const float shininess, float& specularReflectance);
 		Elite::RGBColor Ambient();
 
@@ -96,6 +111,7 @@ namespace Elite
 		Texture* m_pNormal = nullptr;
 		Texture* m_pSpecular = nullptr;
 		Texture* m_pGloss = nullptr;
+		Texture* m_pMaterialTexture = nullptr; //Software shading reads the four maps above through this (one fetch per pixel), only when none of them is block compressed, their own texels are released then
 
 		float m_ElapsedTime = 0.f;
 
@@ -110,10 +126,51 @@ namespace Elite
 
 		float* m_pDepthBufferPixels = nullptr;
 
-		std::vector<Triangle*> m_pTriangles;
 		std::vector<Mesh*> m_pSoftwareMeshes;
+		MeshCache m_VehicleMeshCache{}; //The software vehicle mesh reads its streams straight from this mapping, so it lives as long as the meshes
+		bool m_IsPackedVertices = true; //Vehicle meshes use quantized vertex streams (PackedPosition, PackedFrame), chosen when the meshes are built
+
+		std::unique_ptr<ThreadPool> m_pThreadPool;
+
+		FrameConstants m_FrameConstants{};
+
+		//Screen is split in tiles, a tile is only ever touched by one worker at a time (no locks on color or depth)
+		static const uint32_t m_TileSize{ 32 };
+		uint32_t m_AmountTilesX = 0;
+		uint32_t m_AmountTilesY = 0;
+
+		//Hierarchical Z, max depth per 8x8 block and per tile so whole blocks or triangles behind what is drawn are skipped before any per-pixel work
+		static const uint32_t m_HiZBlockSize{ 8 };
+		uint32_t m_AmountHiZBlocksX = 0;
+		std::vector<float> m_HiZBlocks;
+		std::vector<float> m_HiZTiles;
+		bool m_IsHierarchicalZ = true;
+
+		RasterKernel m_RasterKernel = GetFastestRasterKernel();
+
+		//Triangles made by clipping, rebuilt every frame (deque so setups can keep pointing at them while it grows)
+		VertexStreams m_ClippedStreams;
+		std::deque<Triangle> m_ClippedTriangles;
+
+		//Triangles that need clipping wait for the attribute stage, setupIndex is where their setups go to keep submission order
+		struct DeferredClip
+		{
+			Triangle* pTriangle;
+			uint32_t setupIndex;
+		};
+		std::vector<DeferredClip> m_DeferredClips;
+		std::vector<TriangleSetup> m_UnclippedSetups;
+
+		std::vector<TriangleSetup> m_TriangleSetups;
+		std::vector<std::vector<uint32_t>> m_TileBins;
+
+		//Deferred mode, rasterization only stores triangle ID + barycentrics and every pixel is shaded once afterwards (shading cost independent of overdraw)
+		bool m_IsVisibilityBuffer = false;
+		std::vector<VisibilityPixel> m_VisibilityBuffer;
 
 		bool m_IsNormalMapping = true;
+		Texture::MipFilter m_MipFilter = Texture::MipFilter::Trilinear;
+		Texture::TexelLayout m_TexelLayout = Texture::TexelLayout::RowMajor;
 		bool m_IsDepthBufferColor = false;
 
 		//- Hardware -//
@@ -0,0 +1,37 @@
+#pragma once
+
+#include "EMath.h"
+
+namespace Elite
+{
+	//=== FrameConstants struct ===//
+	//Everything the software stages need that only changes once per frame, computed once before the first stage runs
+	struct FrameConstants
+	{
+		//=== Functions ===//
+		//Perspective divide + viewport transform, same as the vertex stage
+		FPoint4 ClipToScreen(const FPoint4& clipPosition) const
+		{
+			return FPoint4{ ((clipPosition.x / clipPosition.w + 1.f) / 2.f) * width, ((1.f - clipPosition.y / clipPosition.w) / 2.f) * height,
+				clipPosition.z / clipPosition.w, clipPosition.w };
+		}
+
+		//=== Variables ===//
+		FMatrix4 viewMatrix;
+		FMatrix4 projectionMatrix;
+		FMatrix4 viewProjectionMatrix;
+
+		FMatrix4 worldMatrix;
+		FMatrix4 worldViewProjectionMatrix; //Positions go from model to projection space in one transform
+		FMatrix3 normalMatrix; //Inverse transpose of the world matrix
+
+		FPoint3 cameraPosition;
+
+		uint32_t width;
+		uint32_t height;
+
+		//Guard band in NDC units, triangles inside it are rasterized without clipping in x and y
+		float guardBandX;
+		float guardBandY;
+	};
+}
\ No newline at end of file
@@ -0,0 +1,118 @@
+#include "pch.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "MappedFile.h"
+
+//=== Constructor ===//
+MappedFile::MappedFile()
+	: m_pData{ nullptr }
+	, m_Size{}
+#ifdef _WIN32
+	, m_pFile{ nullptr }
+	, m_pMapping{ nullptr }
+#endif
+{
+}
+
+//=== Destructor ===//
+MappedFile::~MappedFile()
+{
+	Close();
+}
+
+//=== Functions ===//
+bool MappedFile::Open(const std::string& filePath)
+{
+	Close();
+
+#ifdef _WIN32
+	HANDLE file{ CreateFileA(filePath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr) };
+	if (file == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+	m_pFile = file;
+
+	LARGE_INTEGER size{};
+	if (!GetFileSizeEx(file, &size) || size.QuadPart == 0)
+	{
+		Close();
+		return false;
+	}
+
+	m_pMapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (!m_pMapping)
+	{
+		Close();
+		return false;
+	}
+
+	m_pData = static_cast<const uint8_t*>(MapViewOfFile(m_pMapping, FILE_MAP_READ, 0, 0, 0));
+	if (!m_pData)
+	{
+		Close();
+		return false;
+	}
+	m_Size = size_t(size.QuadPart);
+#else
+	const int file{ open(filePath.c_str(), O_RDONLY) };
+	if (file < 0)
+	{
+		return false;
+	}
+
+	//The mapping stays valid after the descriptor is closed
+	struct stat status{};
+	void* pData{ MAP_FAILED };
+	if (fstat(file, &status) == 0 && status.st_size > 0)
+	{
+		pData = mmap(nullptr, size_t(status.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+	}
+	close(file);
+
+	if (pData == MAP_FAILED)
+	{
+		return false;
+	}
+	m_pData = static_cast<const uint8_t*>(pData);
+	m_Size = size_t(status.st_size);
+#endif
+
+	return true;
+}
+
+void MappedFile::Close()
+{
+#ifdef _WIN32
+	if (m_pData)
+	{
+		UnmapViewOfFile(m_pData);
+	}
+	if (m_pMapping)
+	{
+		CloseHandle(m_pMapping);
+	}
+	if (m_pFile)
+	{
+		CloseHandle(m_pFile);
+	}
+	m_pMapping = nullptr;
+	m_pFile = nullptr;
+#else
+	if (m_pData)
+	{
+		munmap(const_cast<uint8_t*>(m_pData), m_Size);
+	}
+#endif
+
+	m_pData = nullptr;
+	m_Size = 0;
+}
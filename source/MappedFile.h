@@ -0,0 +1,37 @@
+#pragma once
+
+#include <string>
+
+//=== MappedFile class ===//
+//Read-only view of a whole file, the OS pages it in on first touch so nothing is copied
+class MappedFile final
+{
+public:
+	//=== Constructor ===//
+	MappedFile();
+
+	//=== Rule of five ===//
+	~MappedFile();
+	MappedFile(const MappedFile& mappedFile) = delete;
+	MappedFile(MappedFile&& mappedFile) = delete;
+	MappedFile& operator=(const MappedFile& mappedFile) = delete;
+	MappedFile& operator=(MappedFile&& mappedFile) = delete;
+
+	//=== Functions ===//
+	//False when the file doesn't exist, is empty or can't be mapped
+	bool Open(const std::string& filePath);
+	void Close();
+
+	bool IsOpen() const { return m_pData != nullptr; }
+	const uint8_t* GetData() const { return m_pData; }
+	size_t GetSize() const { return m_Size; }
+
+private:
+	//=== Variables ===//
+	const uint8_t* m_pData;
+	size_t m_Size;
+#ifdef _WIN32
+	void* m_pFile;
+	void* m_pMapping;
+#endif
+};
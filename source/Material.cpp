@@ -7,6 +7,8 @@ Material::Material(ID3D11Device* pDevice, const std::wstring& assetFile, const c
     : m_pEffect{ nullptr }
     , m_pTechnique{ nullptr }
     , m_pMatWorldViewProjVariable{ nullptr }
+    , m_pPositionOffsetVariable{ nullptr }
+    , m_pPositionScaleVariable{ nullptr }
 {
     //Initialize effect;
     m_pEffect = LoadEffect(pDevice, assetFile);
@@ -20,12 +22,18 @@ Material::Material(ID3D11Device* pDevice, const std::wstring& assetFile, const c
     m_pMatWorldViewProjVariable = m_pEffect->GetVariableByName("gWorldViewProj")->AsMatrix();
     if (!m_pMatWorldViewProjVariable->IsValid())
         std::wcout << L"m_pMatWorldViewProjVariable not valid\n";
+
+    //Dequantization of packed vertices (not every effect has it)
+    m_pPositionOffsetVariable = m_pEffect->GetVariableByName("gPositionOffset")->AsVector();
+    m_pPositionScaleVariable = m_pEffect->GetVariableByName("gPositionScale")->AsVector();
 }
 
 //=== Destructor ===//
 Material::~Material()
 {
     m_pMatWorldViewProjVariable->Release();
+    m_pPositionOffsetVariable->Release();
+    m_pPositionScaleVariable->Release();
 
     m_pTechnique->Release();
     m_pEffect->Release();
@@ -41,6 +49,17 @@ void Material::UpdateMatrices(const Elite::FMatrix4& worldMatrix, const Elite::F
     m_pMatWorldViewProjVariable->SetMatrix(reinterpret_cast<const float*>(&worldViewProjectionMatrix.data));
 }
 
+void Material::UpdateVertexQuantization(const VertexQuantization& quantization)
+{
+    if (m_pPositionOffsetVariable->IsValid() && m_pPositionScaleVariable->IsValid())
+    {
+        const float offset[4]{ quantization.offset.x, quantization.offset.y, quantization.offset.z, 0.f };
+        const float scale[4]{ quantization.scale.x, quantization.scale.y, quantization.scale.z, 0.f };
+        m_pPositionOffsetVariable->SetFloatVector(offset);
+        m_pPositionScaleVariable->SetFloatVector(scale);
+    }
+}
+
 ID3DX11Effect* Material::LoadEffect(ID3D11Device* pDevice, const std::wstring& assetFile)
 {
     HRESULT result = S_OK;
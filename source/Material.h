@@ -3,6 +3,8 @@
 #include <string>
 #include <sstream>
 
+#include "PackedVertex.h"
+
 //=== Material class ===//
 class Material
 {
@@ -26,6 +28,7 @@ public:
 	virtual void UpdateMatrices(const Elite::FMatrix4& worldMatrix, const Elite::FMatrix4& viewMatrix, const Elite::FMatrix4& projectionMatrix);
 	virtual void UpdateResources(ID3D11ShaderResourceView* pDiffuseView = nullptr, ID3D11ShaderResourceView* pNormalView = nullptr,
 		ID3D11ShaderResourceView* pSpecularView = nullptr, ID3D11ShaderResourceView* pGlossinessView = nullptr) = 0;
+	void UpdateVertexQuantization(const VertexQuantization& quantization); //Only for effects with the packed vertex shader
 
 protected:
 	//=== Variables ===//
@@ -35,4 +38,8 @@ protected:
 	ID3DX11EffectTechnique* m_pTechnique;
 
 	ID3DX11EffectMatrixVariable* m_pMatWorldViewProjVariable;
+
+	//Optional, invalid when the effect has no packed vertex shader
+	ID3DX11EffectVectorVariable* m_pPositionOffsetVariable;
+	ID3DX11EffectVectorVariable* m_pPositionScaleVariable;
 };
\ No newline at end of file
@@ -1,21 +1,39 @@
 #include "pch.h"
 
+#include <cstddef>
+
 #include "Texture.h"
 #include "Material.h"
 #include "Mesh.h"
+#include "MeshCache.h"
 #include "Triangle.h"
 
 //=== Constructors ===//
 //- Software -//
 Mesh::Mesh(const std::vector<Vertex>& vertexBuffer, const std::vector<int>& indexBuffer, PrimitiveTopology primitiveTopology)
-	: m_VertexBuffer{ vertexBuffer }
+	: m_AmountVertices{ vertexBuffer.size() }
+	, m_pPositions{ nullptr }
+	, m_pNormals{ nullptr }
+	, m_pTangents{ nullptr }
+	, m_pPackedPositions{ nullptr }
+	, m_pPackedFrames{ nullptr }
+	, m_Positions{}
+	, m_Normals{}
+	, m_Tangents{}
+	, m_Streams{}
+	, m_IsVertexUsed{}
 	, m_IndexBuffer{ indexBuffer }
 	, m_PrimitiveTopology{ primitiveTopology }
+	, m_SubMeshes{ SubMesh{ "", 0, uint32_t(indexBuffer.size()) } }
+	, m_VertexFormat{ VertexFormat::Full }
+	, m_Quantization{}
 	, m_UIndexBuffer{}
 
 	, m_AmountIndices{}
 	, m_pIndexBuffer{ nullptr }
-	, m_pVertexBuffer{ nullptr }
+	, m_pVertexBuffers{}
+	, m_VertexStrides{}
+	, m_AmountVertexBuffers{}
 	, m_pVertexLayout{ nullptr }
 	, m_pMaterial{ nullptr }
 	, m_pDiffuse{ nullptr }
@@ -23,18 +41,69 @@ Mesh::Mesh(const std::vector<Vertex>& vertexBuffer, const std::vector<int>& inde
 	, m_pSpecular{ nullptr }
 	, m_pGlossiness{ nullptr }
 {
-	Initialize(m_IndexBuffer);
+	InitializeStreams(vertexBuffer.data());
+	Initialize(m_IndexBuffer.data(), m_IndexBuffer.size());
 }
 
 Mesh::Mesh(const std::vector<Vertex>& vertexBuffer, const std::vector<uint32_t>& indexBuffer, PrimitiveTopology primitiveTopology)
-	: m_VertexBuffer{ vertexBuffer }
+	: m_AmountVertices{ vertexBuffer.size() }
+	, m_pPositions{ nullptr }
+	, m_pNormals{ nullptr }
+	, m_pTangents{ nullptr }
+	, m_pPackedPositions{ nullptr }
+	, m_pPackedFrames{ nullptr }
+	, m_Positions{}
+	, m_Normals{}
+	, m_Tangents{}
+	, m_Streams{}
+	, m_IsVertexUsed{}
 	, m_UIndexBuffer{ indexBuffer }
 	, m_PrimitiveTopology{ primitiveTopology }
+	, m_SubMeshes{ SubMesh{ "", 0, uint32_t(indexBuffer.size()) } }
+	, m_VertexFormat{ VertexFormat::Full }
+	, m_Quantization{}
+	, m_IndexBuffer{}
+
+	, m_AmountIndices{}
+	, m_pIndexBuffer{ nullptr }
+	, m_pVertexBuffers{}
+	, m_VertexStrides{}
+	, m_AmountVertexBuffers{}
+	, m_pVertexLayout{ nullptr }
+	, m_pMaterial{ nullptr }
+	, m_pDiffuse{ nullptr }
+	, m_pNormal{ nullptr }
+	, m_pSpecular{ nullptr }
+	, m_pGlossiness{ nullptr }
+{
+	InitializeStreams(vertexBuffer.data());
+	Initialize(m_UIndexBuffer.data(), m_UIndexBuffer.size());
+}
+
+Mesh::Mesh(const MeshCache& meshCache, PrimitiveTopology primitiveTopology, VertexFormat vertexFormat)
+	: m_AmountVertices{ meshCache.GetAmountVertices() }
+	, m_pPositions{ nullptr }
+	, m_pNormals{ nullptr }
+	, m_pTangents{ nullptr }
+	, m_pPackedPositions{ nullptr }
+	, m_pPackedFrames{ nullptr }
+	, m_Positions{}
+	, m_Normals{}
+	, m_Tangents{}
+	, m_Streams{}
+	, m_IsVertexUsed{}
+	, m_PrimitiveTopology{ primitiveTopology }
+	, m_SubMeshes{ meshCache.GetSubMeshes() }
+	, m_VertexFormat{ vertexFormat }
+	, m_Quantization{ Elite::MakeVertexQuantization(meshCache.GetBoundsMin(), meshCache.GetBoundsMax()) }
 	, m_IndexBuffer{}
+	, m_UIndexBuffer{}
 
 	, m_AmountIndices{}
 	, m_pIndexBuffer{ nullptr }
-	, m_pVertexBuffer{ nullptr }
+	, m_pVertexBuffers{}
+	, m_VertexStrides{}
+	, m_AmountVertexBuffers{}
 	, m_pVertexLayout{ nullptr }
 	, m_pMaterial{ nullptr }
 	, m_pDiffuse{ nullptr }
@@ -42,14 +111,68 @@ Mesh::Mesh(const std::vector<Vertex>& vertexBuffer, const std::vector<uint32_t>&
 	, m_pSpecular{ nullptr }
 	, m_pGlossiness{ nullptr }
 {
-	Initialize(m_UIndexBuffer);
+	InitializeStreams(meshCache.GetStreams(), meshCache.HasColors());
+
+	//Triangles only keep the indices, no need to hold on to the index buffer
+	Initialize(meshCache.GetIndices(), meshCache.GetAmountIndices());
 }
 
 //- Hardware -//
 Mesh::Mesh(ID3D11Device* pDevice, const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices, Material* pMaterial, Texture* pDiffuse, Texture* pNormal, Texture* pSpecular, Texture* pGlossiness)
 	: m_AmountIndices{ uint32_t(indices.size()) }
 	, m_pIndexBuffer{ nullptr }
-	, m_pVertexBuffer{ nullptr }
+	, m_pVertexBuffers{}
+	, m_VertexStrides{}
+	, m_AmountVertexBuffers{}
+	, m_pVertexLayout{ nullptr }
+	, m_pMaterial{ pMaterial }
+	, m_pDiffuse{ pDiffuse }
+	, m_pNormal{ pNormal }
+	, m_pSpecular{ pSpecular }
+	, m_pGlossiness{ pGlossiness }
+
+	, m_AmountVertices{}
+	, m_pPositions{ nullptr }
+	, m_pNormals{ nullptr }
+	, m_pTangents{ nullptr }
+	, m_pPackedPositions{ nullptr }
+	, m_pPackedFrames{ nullptr }
+	, m_Positions{}
+	, m_Normals{}
+	, m_Tangents{}
+	, m_Streams{}
+	, m_IsVertexUsed{}
+	, m_IndexBuffer{}
+	, m_UIndexBuffer{}
+	, m_PrimitiveTopology{}
+	, m_SubMeshes{ SubMesh{ "", 0, uint32_t(indices.size()) } }
+	, m_VertexFormat{ VertexFormat::Full }
+	, m_Quantization{}
+{
+	//Split into streams only for the upload (full format, nothing is packed)
+	std::vector<Elite::FPoint4> positions{};
+	std::vector<Elite::FVector3> normals{};
+	std::vector<Elite::FVector4> tangents{};
+	std::vector<Elite::FVector2> UVs{};
+	std::vector<Elite::RGBColor> colors{};
+	for (const Vertex& vertex : vertices)
+	{
+		positions.push_back(Elite::FPoint4{ vertex.position.x, vertex.position.y, vertex.position.z, 1.f });
+		normals.push_back(vertex.normal);
+		tangents.push_back(Elite::FVector4{ vertex.tangent, vertex.tangentSign });
+		UVs.push_back(vertex.uv);
+		colors.push_back(vertex.color);
+	}
+	const MeshStreams streams{ positions.data(), normals.data(), tangents.data(), UVs.data(), colors.data() };
+	Initialize(pDevice, streams, vertices.size(), indices.data(), indices.size());
+}
+
+Mesh::Mesh(ID3D11Device* pDevice, const MeshCache& meshCache, Material* pMaterial, VertexFormat vertexFormat, Texture* pDiffuse, Texture* pNormal, Texture* pSpecular, Texture* pGlossiness)
+	: m_AmountIndices{ uint32_t(meshCache.GetAmountIndices()) }
+	, m_pIndexBuffer{ nullptr }
+	, m_pVertexBuffers{}
+	, m_VertexStrides{}
+	, m_AmountVertexBuffers{}
 	, m_pVertexLayout{ nullptr }
 	, m_pMaterial{ pMaterial }
 	, m_pDiffuse{ pDiffuse }
@@ -57,12 +180,26 @@ Mesh::Mesh(ID3D11Device* pDevice, const std::vector<Vertex>& vertices, const std
 	, m_pSpecular{ pSpecular }
 	, m_pGlossiness{ pGlossiness }
 
-	, m_VertexBuffer{}
+	, m_AmountVertices{}
+	, m_pPositions{ nullptr }
+	, m_pNormals{ nullptr }
+	, m_pTangents{ nullptr }
+	, m_pPackedPositions{ nullptr }
+	, m_pPackedFrames{ nullptr }
+	, m_Positions{}
+	, m_Normals{}
+	, m_Tangents{}
+	, m_Streams{}
+	, m_IsVertexUsed{}
 	, m_IndexBuffer{}
 	, m_UIndexBuffer{}
 	, m_PrimitiveTopology{}
+	, m_SubMeshes{ meshCache.GetSubMeshes() }
+	, m_VertexFormat{ vertexFormat }
+	, m_Quantization{ Elite::MakeVertexQuantization(meshCache.GetBoundsMin(), meshCache.GetBoundsMax()) }
 {
-	Initialize(pDevice, vertices, indices);
+	//Uploaded straight from the streams of the mapped cache
+	Initialize(pDevice, meshCache.GetStreams(), meshCache.GetAmountVertices(), meshCache.GetIndices(), meshCache.GetAmountIndices());
 }
 
 //=== Destructor ===//
@@ -79,9 +216,9 @@ Mesh::~Mesh()
 	{
 		m_pVertexLayout->Release();
 	}
-	if (m_pVertexBuffer)
+	for (uint32_t i{}; i < m_AmountVertexBuffers; ++i)
 	{
-		m_pVertexBuffer->Release();
+		m_pVertexBuffers[i]->Release();
 	}
 	if (m_pIndexBuffer)
 	{
@@ -92,113 +229,283 @@ Mesh::~Mesh()
 //=== Functions ===//
 //- Software -//
 template <typename myType>
-void Mesh::Initialize(const std::vector<myType>& indexBuffer)
+void Mesh::Initialize(const myType* indexBuffer, size_t amountIndices)
 {
-	//Initialize triangles with correct primitive topology
+	//Initialize triangles with correct primitive topology (triangles only hold the indices)
 	if (m_PrimitiveTopology == PrimitiveTopology::TriangleList)
 	{
-		for (size_t i{}; i < indexBuffer.size(); i += 3)
+		for (size_t i{}; i + 2 < amountIndices; i += 3)
 		{
-			//Pull the vertex values with the indices
-			const Vertex vertex0 = m_VertexBuffer[indexBuffer[i + size_t(0)]];
-			const Vertex vertex1 = m_VertexBuffer[indexBuffer[i + size_t(1)]];
-			const Vertex vertex2 = m_VertexBuffer[indexBuffer[i + size_t(2)]];
+			//Pull the indices
+			const uint32_t index0 = uint32_t(indexBuffer[i + size_t(0)]);
+			const uint32_t index1 = uint32_t(indexBuffer[i + size_t(1)]);
+			const uint32_t index2 = uint32_t(indexBuffer[i + size_t(2)]);
 
 			//Push triangle to vector
-			m_pTriangles.push_back(new Triangle{ vertex0, vertex1, vertex2 });
+			m_pTriangles.push_back(new Triangle{ m_Streams, index0, index1, index2 });
 		}
 	}
 	else if (m_PrimitiveTopology == PrimitiveTopology::TriangleStrip)
 	{
-		for (size_t i{}; i < indexBuffer.size() - 2; i += 1)
+		for (size_t i{}; i + 2 < amountIndices; i += 1)
 		{
 			//Check if triangle has surface (if no surface -> no triangle is made) (a triangle has no surface if 2 vertices are the same)
 			if (indexBuffer[i + size_t(0)] != indexBuffer[i + size_t(1)] && indexBuffer[i + size_t(0)] != indexBuffer[i + size_t(2)] && indexBuffer[i + size_t(1)] != indexBuffer[i + size_t(2)])
 			{
-				//Pull the vertex values with the indices
-				const Vertex vertex0 = m_VertexBuffer[indexBuffer[i + size_t(0)]];
-				const Vertex vertex1 = m_VertexBuffer[indexBuffer[i + size_t(1)]];
-				const Vertex vertex2 = m_VertexBuffer[indexBuffer[i + size_t(2)]];
+				//Pull the indices
+				const uint32_t index0 = uint32_t(indexBuffer[i + size_t(0)]);
+				const uint32_t index1 = uint32_t(indexBuffer[i + size_t(1)]);
+				const uint32_t index2 = uint32_t(indexBuffer[i + size_t(2)]);
 
 				//Push triangle to vector, change last two vertices if it's an odd triangle (triangle-strip calculation)
 				if (i % 2)
 				{
-					m_pTriangles.push_back(new Triangle{ vertex0, vertex2, vertex1 });
+					m_pTriangles.push_back(new Triangle{ m_Streams, index0, index2, index1 });
 				}
 				else
 				{
-					m_pTriangles.push_back(new Triangle{ vertex0, vertex1, vertex2 });
+					m_pTriangles.push_back(new Triangle{ m_Streams, index0, index1, index2 });
 				}
 			}
 		}
 	}
 }
 
+void Mesh::InitializeStreams(const Vertex* pVertices)
+{
+	//Only meshes that actually have vertex colors get a color stream
+	const bool hasColors{ std::any_of(pVertices, pVertices + m_AmountVertices, [](const Vertex& vertex)
+		{
+			return vertex.color.r != 0.f || vertex.color.g != 0.f || vertex.color.b != 0.f;
+		}) };
+
+	m_Streams.Resize(m_AmountVertices, hasColors);
+	m_IsVertexUsed.assign(m_AmountVertices, 0);
+
+	m_Positions.reserve(m_AmountVertices);
+	m_Normals.reserve(m_AmountVertices);
+	m_Tangents.reserve(m_AmountVertices);
+	for (size_t i{}; i < m_AmountVertices; ++i)
+	{
+		const Vertex& vertex{ pVertices[i] };
+		m_Positions.push_back(Elite::FPoint4{ vertex.position.x, vertex.position.y, vertex.position.z, 1.f });
+		m_Normals.push_back(vertex.normal);
+		m_Tangents.push_back(Elite::FVector4{ vertex.tangent, vertex.tangentSign });
+
+		VertexAttributes& attributes{ m_Streams.attributes[i] };
+		attributes.uv = vertex.uv;
+		attributes.tangentSign = vertex.tangentSign;
+		if (hasColors)
+		{
+			m_Streams.colors[i] = vertex.color;
+		}
+	}
+
+	m_pPositions = m_Positions.data();
+	m_pNormals = m_Normals.data();
+	m_pTangents = m_Tangents.data();
+}
+
+void Mesh::InitializeStreams(const MeshStreams& streams, bool hasColors)
+{
+	m_Streams.Resize(m_AmountVertices, hasColors);
+	m_IsVertexUsed.assign(m_AmountVertices, 0);
+
+	//Source streams are read in place, only the post-transform streams get what never changes (uv, tangent sign, color) once
+	//Packed meshes decode it from the packed streams, so they shade exactly like the hardware
+	const bool isPacked{ m_VertexFormat == VertexFormat::Packed };
+	if (isPacked)
+	{
+		m_pPackedPositions = streams.pPackedPositions;
+		m_pPackedFrames = streams.pPackedFrames;
+	}
+	else
+	{
+		m_pPositions = streams.pPositions;
+		m_pNormals = streams.pNormals;
+		m_pTangents = streams.pTangents;
+	}
+
+	for (size_t i{}; i < m_AmountVertices; ++i)
+	{
+		VertexAttributes& attributes{ m_Streams.attributes[i] };
+		Elite::RGBColor color{};
+		if (isPacked)
+		{
+			attributes.tangentSign = Elite::UnpackTangentSign(streams.pPackedPositions[i]);
+			Elite::UnpackAttributes(streams.pPackedAttributes[i], attributes.uv, color);
+		}
+		else
+		{
+			attributes.tangentSign = streams.pTangents[i].w;
+			attributes.uv = streams.pUVs[i];
+			color = streams.pColors[i];
+		}
+
+		if (hasColors)
+		{
+			m_Streams.colors[i] = color;
+		}
+	}
+}
+
+void Mesh::ModelToNDC(size_t begin, size_t end, const Elite::FrameConstants& constants)
+{
+	for (size_t i{ begin }; i < end; ++i)
+	{
+		//Straight from model to projection space, the world position is only needed for shading (TransformAttributes)
+		const Elite::FPoint4 position{ m_pPackedPositions ? Elite::UnpackPosition(m_pPackedPositions[i], m_Quantization) : m_pPositions[i] };
+		Elite::FPoint4 pos{ constants.worldViewProjectionMatrix * position };
+		m_Streams.clipPositions[i] = pos;
+
+		//Transform all vertices from view space to NDC coordinates (projection space) => (perspective divide)
+		pos.x /= pos.w;
+		pos.y /= pos.w;
+		pos.z /= pos.w;
+
+		m_Streams.screenPositions[i] = pos;
+	}
+}
+
+void Mesh::NDCToScreen(size_t begin, size_t end, const Elite::FrameConstants& constants)
+{
+	for (size_t i{ begin }; i < end; ++i)
+	{
+		Elite::FPoint4& pos{ m_Streams.screenPositions[i] };
+
+		//Transfrom all vertices from projection space to screen space
+		pos.x = ((pos.x + 1.f) / 2.f) * constants.width;
+		pos.y = ((1.f - pos.y) / 2.f) * constants.height;
+	}
+}
+
+void Mesh::UseVertices(const Triangle* pTriangle)
+{
+	for (int i{}; i < 3; ++i)
+	{
+		m_IsVertexUsed[pTriangle->GetIndex(i)] = 1;
+	}
+}
+
+void Mesh::TransformAttributes(size_t begin, size_t end, const Elite::FrameConstants& constants)
+{
+	for (size_t i{ begin }; i < end; ++i)
+	{
+		//Culled vertices keep last frame's attributes, nothing reads them
+		if (!m_IsVertexUsed[i])
+		{
+			continue;
+		}
+		m_IsVertexUsed[i] = 0;
+
+		//Decode packed vertices first (only what gets transformed)
+		Elite::FPoint4 position{};
+		Elite::FVector3 normal{}, tangent{};
+		if (m_pPackedPositions)
+		{
+			position = Elite::UnpackPosition(m_pPackedPositions[i], m_Quantization);
+			Elite::UnpackFrame(m_pPackedFrames[i], normal, tangent);
+		}
+		else
+		{
+			position = m_pPositions[i];
+			normal = m_pNormals[i];
+			tangent = Elite::FVector3{ m_pTangents[i] };
+		}
+
+		//Transform the normal and tangent to world space (uv, tangent sign and color never change)
+		VertexAttributes& attributes{ m_Streams.attributes[i] };
+		const Elite::FPoint4 worldPosition{ constants.worldMatrix * position };
+		attributes.normal = Elite::GetNormalized(constants.normalMatrix * normal);
+		attributes.tangent = Elite::GetNormalized(constants.normalMatrix * tangent);
+		attributes.viewDirection = Elite::GetNormalized(worldPosition.xyz - constants.cameraPosition);
+	}
+}
+
 //- Hardware -//
-void Mesh::Initialize(ID3D11Device* pDevice, const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices)
+void Mesh::Initialize(ID3D11Device* pDevice, const MeshStreams& streams, size_t amountVertices, const uint32_t* pIndices, size_t amountIndices)
 {
-	//Create Vertex Layout
+	//Create Vertex Layout, every stream is bound to its own input slot
 	HRESULT result = S_OK;
-	static const uint32_t numElements{ 5 };
-	D3D11_INPUT_ELEMENT_DESC vertexDesc[numElements]{};
-
-	vertexDesc[0].SemanticName = "POSITION";
-	vertexDesc[0].Format = DXGI_FORMAT_R32G32B32A32_FLOAT;
-	vertexDesc[0].AlignedByteOffset = 0;
-	vertexDesc[0].InputSlotClass = D3D11_INPUT_PER_VERTEX_DATA;
-
-	vertexDesc[1].SemanticName = "COLOR";
-	vertexDesc[1].Format = DXGI_FORMAT_R32G32B32_FLOAT;
-	vertexDesc[1].AlignedByteOffset = 16;
-	vertexDesc[1].InputSlotClass = D3D11_INPUT_PER_VERTEX_DATA;
-
-	vertexDesc[2].SemanticName = "TEXCOORD";
-	vertexDesc[2].Format = DXGI_FORMAT_R32G32_FLOAT;
-	vertexDesc[2].AlignedByteOffset = 28;
-	vertexDesc[2].InputSlotClass = D3D11_INPUT_PER_VERTEX_DATA;
-
-	vertexDesc[3].SemanticName = "NORMAL";
-	vertexDesc[3].Format = DXGI_FORMAT_R32G32B32_FLOAT;
-	vertexDesc[3].AlignedByteOffset = 36;
-	vertexDesc[3].InputSlotClass = D3D11_INPUT_PER_VERTEX_DATA;
-
-	vertexDesc[4].SemanticName = "TANGENT";
-	vertexDesc[4].Format = DXGI_FORMAT_R32G32B32_FLOAT;
-	vertexDesc[4].AlignedByteOffset = 48;
-	vertexDesc[4].InputSlotClass = D3D11_INPUT_PER_VERTEX_DATA;
-
-	//Create vertex buffer
+	D3D11_INPUT_ELEMENT_DESC vertexDesc[m_MaxVertexBuffers]{};
+	const void* pStreams[m_MaxVertexBuffers]{};
+	uint32_t amountElements{};
+	const auto addElement = [&](const char* semanticName, DXGI_FORMAT format, UINT offset, const void* pStream, UINT stride)
+	{
+		//Attributes that share a stream share its slot
+		uint32_t slot{};
+		while (slot < m_AmountVertexBuffers && pStreams[slot] != pStream)
+		{
+			++slot;
+		}
+		if (slot == m_AmountVertexBuffers)
+		{
+			pStreams[slot] = pStream;
+			m_VertexStrides[slot] = stride;
+			++m_AmountVertexBuffers;
+		}
+
+		D3D11_INPUT_ELEMENT_DESC& element{ vertexDesc[amountElements++] };
+		element.SemanticName = semanticName;
+		element.Format = format;
+		element.InputSlot = slot;
+		element.AlignedByteOffset = offset;
+		element.InputSlotClass = D3D11_INPUT_PER_VERTEX_DATA;
+	};
+
+	if (m_VertexFormat == VertexFormat::Packed)
+	{
+		//Decoded by the packed vertex shader, the tangent lives in NORMAL.zw and its sign in POSITION.w
+		addElement("POSITION", DXGI_FORMAT_R16G16B16A16_UNORM, 0, streams.pPackedPositions, sizeof(PackedPosition));
+		addElement("NORMAL", DXGI_FORMAT_R16G16B16A16_SNORM, 0, streams.pPackedFrames, sizeof(PackedFrame));
+		addElement("TEXCOORD", DXGI_FORMAT_R16G16_FLOAT, offsetof(PackedAttributes, uv), streams.pPackedAttributes, sizeof(PackedAttributes));
+		addElement("COLOR", DXGI_FORMAT_R8G8B8A8_UNORM, offsetof(PackedAttributes, color), streams.pPackedAttributes, sizeof(PackedAttributes));
+	}
+	else
+	{
+		addElement("POSITION", DXGI_FORMAT_R32G32B32A32_FLOAT, 0, streams.pPositions, sizeof(Elite::FPoint4));
+		addElement("COLOR", DXGI_FORMAT_R32G32B32_FLOAT, 0, streams.pColors, sizeof(Elite::RGBColor));
+		addElement("TEXCOORD", DXGI_FORMAT_R32G32_FLOAT, 0, streams.pUVs, sizeof(Elite::FVector2));
+		addElement("NORMAL", DXGI_FORMAT_R32G32B32_FLOAT, 0, streams.pNormals, sizeof(Elite::FVector3));
+		addElement("TANGENT", DXGI_FORMAT_R32G32B32A32_FLOAT, 0, streams.pTangents, sizeof(Elite::FVector4)); //w = tangentSign
+	}
+
+	//Create vertex buffers, straight from the streams
 	D3D11_BUFFER_DESC bd{};
-	bd.Usage = D3D11_USAGE_IMMUTABLE;
-	bd.ByteWidth = sizeof(Vertex) * (uint32_t)vertices.size();
-	bd.BindFlags = D3D11_BIND_VERTEX_BUFFER;
-	bd.CPUAccessFlags = 0;
-	bd.MiscFlags = 0;
 	D3D11_SUBRESOURCE_DATA initData{ 0 };
-	initData.pSysMem = vertices.data();
-	result = pDevice->CreateBuffer(&bd, &initData, &m_pVertexBuffer);
-	if (FAILED(result))
+	for (uint32_t i{}; i < m_AmountVertexBuffers; ++i)
 	{
-		return;
+		bd.Usage = D3D11_USAGE_IMMUTABLE;
+		bd.ByteWidth = m_VertexStrides[i] * (uint32_t)amountVertices;
+		bd.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+		bd.CPUAccessFlags = 0;
+		bd.MiscFlags = 0;
+		initData.pSysMem = pStreams[i];
+		result = pDevice->CreateBuffer(&bd, &initData, &m_pVertexBuffers[i]);
+		if (FAILED(result))
+		{
+			m_AmountVertexBuffers = i;
+			return;
+		}
 	}
 
 	//Create the input layout
 	D3DX11_PASS_DESC passDesc;
 	m_pMaterial->GetTechnique()->GetPassByIndex(0)->GetDesc(&passDesc);
-	result = pDevice->CreateInputLayout(vertexDesc, numElements, passDesc.pIAInputSignature, passDesc.IAInputSignatureSize, &m_pVertexLayout);
+	result = pDevice->CreateInputLayout(vertexDesc, amountElements, passDesc.pIAInputSignature, passDesc.IAInputSignatureSize, &m_pVertexLayout);
 	if (FAILED(result))
 	{
 		return;
 	}
 
 	//Create index buffer
-	m_AmountIndices = (uint32_t)indices.size();
+	m_AmountIndices = (uint32_t)amountIndices;
 	bd.Usage = D3D11_USAGE_IMMUTABLE;
 	bd.ByteWidth = sizeof(uint32_t) * m_AmountIndices;
 	bd.BindFlags = D3D11_BIND_INDEX_BUFFER;
 	bd.CPUAccessFlags = 0;
 	bd.MiscFlags = 0;
-	initData.pSysMem = indices.data();
+	initData.pSysMem = pIndices;
 	result = pDevice->CreateBuffer(&bd, &initData, &m_pIndexBuffer);
 	if (FAILED(result))
 	{
@@ -208,10 +515,9 @@ void Mesh::Initialize(ID3D11Device* pDevice, const std::vector<Vertex>& vertices
 
 void Mesh::Render(ID3D11DeviceContext* pDeviceContext, const Filter& filter, const Triangle::CullMode& cull, const Elite::FMatrix4& worldMatrix, const Elite::FMatrix4& viewMatrix, const Elite::FMatrix4& projectionMatrix)
 {
-	//Set vertex buffer
-	UINT stride = sizeof(Vertex);
-	UINT offset = 0;
-	pDeviceContext->IASetVertexBuffers(0, 1, &m_pVertexBuffer, &stride, &offset);
+	//Set vertex buffers
+	const UINT offsets[m_MaxVertexBuffers]{};
+	pDeviceContext->IASetVertexBuffers(0, m_AmountVertexBuffers, m_pVertexBuffers, m_VertexStrides, offsets);
 
 	//Set index buffer
 	pDeviceContext->IASetIndexBuffer(m_pIndexBuffer, DXGI_FORMAT_R32_UINT, 0);
@@ -224,6 +530,10 @@ void Mesh::Render(ID3D11DeviceContext* pDeviceContext, const Filter& filter, con
 
 	//Update GPU memory with matrices
 	m_pMaterial->UpdateMatrices(worldMatrix, viewMatrix, projectionMatrix);
+	if (m_VertexFormat == VertexFormat::Packed)
+	{
+		m_pMaterial->UpdateVertexQuantization(m_Quantization);
+	}
 
 	//Update GPU memory with textures
 	ID3D11ShaderResourceView* diffuseResource{ m_pDiffuse ? m_pDiffuse->GetResourceView() : nullptr };
@@ -249,9 +559,12 @@ void Mesh::Render(ID3D11DeviceContext* pDeviceContext, const Filter& filter, con
 		index = MakeTechniquePassIndex(filter, cull);
 	}
 
-	//Render triangle
+	//Render triangles, one draw per submesh range (all submeshes share the mesh textures)
 	m_pMaterial->GetTechnique()->GetPassByIndex(index)->Apply(0, pDeviceContext);
-	pDeviceContext->DrawIndexed(m_AmountIndices, 0, 0);
+	for (const SubMesh& subMesh : m_SubMeshes)
+	{
+		pDeviceContext->DrawIndexed(subMesh.amountIndices, subMesh.firstIndex, 0);
+	}
 }
 
 UINT Mesh::MakeTechniquePassIndex(const Filter& filter, const Triangle::CullMode& cull)
@@ -4,9 +4,14 @@
 
 #include "Vertex.h"
 #include "Triangle.h"
+#include "SubMesh.h"
+#include "PackedVertex.h"
+#include "FrameConstants.h"
 
 class Texture;
 class Material;
+class MeshCache;
+struct MeshStreams;
 
 //=== Mesh class ===//
 class Mesh final
@@ -28,13 +33,23 @@ public:
 		TriangleStrip,
 	};
 
+	//=== VertexFormat enum class ===//
+	enum class VertexFormat
+	{
+		Full,
+		Packed, //PackedPosition, PackedFrame and PackedAttributes, needs a technique with the packed vertex shader on hardware
+	};
+
 	//=== Constructors ===//
 	//- Software -//
 	Mesh(const std::vector<Vertex>& vertexBuffer, const std::vector<int>& indexBuffer, PrimitiveTopology primitiveTopology);
 	Mesh(const std::vector<Vertex>& vertexBuffer, const std::vector<uint32_t>& indexBuffer, PrimitiveTopology primitiveTopology);
+	Mesh(const MeshCache& meshCache, PrimitiveTopology primitiveTopology, VertexFormat vertexFormat = VertexFormat::Full); //Reads the streams of meshCache every frame, it has to outlive the mesh
 	//- Hardware -//
 	Mesh(ID3D11Device* pDevice, const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices, Material* pMaterial,
 		Texture* pDiffuse = nullptr, Texture* pNormal = nullptr, Texture* pSpecular = nullptr, Texture* pGlossiness = nullptr);
+	Mesh(ID3D11Device* pDevice, const MeshCache& meshCache, Material* pMaterial, VertexFormat vertexFormat = VertexFormat::Full,
+		Texture* pDiffuse = nullptr, Texture* pNormal = nullptr, Texture* pSpecular = nullptr, Texture* pGlossiness = nullptr);
 
 	//=== Rule of five ===//
 	~Mesh();
@@ -44,35 +59,68 @@ public:
 	Mesh& operator=(Mesh&& mesh) = delete;
 
 	//=== Functions ===//
+	const std::vector<SubMesh>& GetSubMeshes() const { return m_SubMeshes; }
+
 	//- Software -//
-	std::vector<Triangle*> GetTriangles() { return m_pTriangles; }
+	const std::vector<Triangle*>& GetTriangles() const { return m_pTriangles; }
+	size_t GetAmountVertices() const { return m_AmountVertices; }
+
+	//Vertex stage, transforms the vertices [begin, end) into the post-transform streams
+	//Positions first (every vertex), culling then flags the used vertices and only those get their attributes transformed
+	void ModelToNDC(size_t begin, size_t end, const Elite::FrameConstants& constants);
+	void NDCToScreen(size_t begin, size_t end, const Elite::FrameConstants& constants);
+	void UseVertices(const Triangle* pTriangle);
+	void TransformAttributes(size_t begin, size_t end, const Elite::FrameConstants& constants); //Clears the flags of the vertices it transformed
 private:
+	void InitializeStreams(const Vertex* pVertices);
+	void InitializeStreams(const MeshStreams& streams, bool hasColors);
 	template <typename myType>	//=> Templated initialize <=//
-	void Initialize(const std::vector<myType>& indexBuffer);
+	void Initialize(const myType* indexBuffer, size_t amountIndices);
 
 public:
 	//- Hardware -//
 	void Render(ID3D11DeviceContext* pDeviceContext, const Filter& filter, const Triangle::CullMode& cull, const Elite::FMatrix4& worldMatrix, const Elite::FMatrix4& viewMatrix, const Elite::FMatrix4& projectionMatrix);
 private:
-	void Initialize(ID3D11Device* pDevice, const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices);
+	void Initialize(ID3D11Device* pDevice, const MeshStreams& streams, size_t amountVertices, const uint32_t* pIndices, size_t amountIndices);
 	UINT MakeTechniquePassIndex(const Filter& filter, const Triangle::CullMode& cull);
 
 private:
 	//=== Variables ===//
 	//- Software -//
-	std::vector<Vertex> m_VertexBuffer;
+	size_t m_AmountVertices;
+	//Source vertices in streams (SoA), positions are read every frame, normals and tangents only for used vertices
+	//They point into the mesh cache, or into the vectors below for meshes built from vertices
+	const Elite::FPoint4* m_pPositions; //w = 1
+	const Elite::FVector3* m_pNormals;
+	const Elite::FVector4* m_pTangents; //w = tangent sign
+	const PackedPosition* m_pPackedPositions; //Replace positions, normals and tangents when packed
+	const PackedFrame* m_pPackedFrames;
+	std::vector<Elite::FPoint4> m_Positions;
+	std::vector<Elite::FVector3> m_Normals;
+	std::vector<Elite::FVector4> m_Tangents;
+	VertexStreams m_Streams; //Post-transform, uv, tangent sign and colors are filled once
+	std::vector<uint8_t> m_IsVertexUsed; //Referenced by a triangle that survived culling this frame
 
 	const std::vector<int> m_IndexBuffer;
 	const std::vector<uint32_t> m_UIndexBuffer;
 
 	const PrimitiveTopology m_PrimitiveTopology;
 
+	std::vector<SubMesh> m_SubMeshes; //Hardware draws one range per submesh, without submeshes the whole index buffer is one
+
+	VertexFormat m_VertexFormat;
+	VertexQuantization m_Quantization;
+
 	std::vector<Triangle*> m_pTriangles;
 
 	//- Hardware -//
 	uint32_t m_AmountIndices;
+	//One vertex buffer per stream, each bound to its own input slot
+	static const uint32_t m_MaxVertexBuffers{ 5 };
 	ID3D11Buffer* m_pIndexBuffer;
-	ID3D11Buffer* m_pVertexBuffer;
+	ID3D11Buffer* m_pVertexBuffers[m_MaxVertexBuffers];
+	UINT m_VertexStrides[m_MaxVertexBuffers];
+	uint32_t m_AmountVertexBuffers;
 	ID3D11InputLayout* m_pVertexLayout;
 
 	Material* m_pMaterial;
@@ -0,0 +1,383 @@
+#include "pch.h"
+
+#include <chrono>
+#include <cstring>
+
+#include "EOBJParser.h"
+#include "MeshCache.h"
+#include "CookedFile.h"
+
+//=== Helpers ===//
+namespace
+{
+	//Vertex streams of the cooked file, each one a cache line aligned section with one element per vertex
+	enum CookedStream : uint32_t
+	{
+		PositionStream,
+		NormalStream,
+		TangentStream,
+		UVStream,
+		ColorStream,
+		PackedPositionStream,
+		PackedFrameStream,
+		PackedAttributesStream,
+		AmountStreams,
+	};
+	const size_t g_StreamElementSizes[AmountStreams]{ sizeof(Elite::FPoint4), sizeof(Elite::FVector3), sizeof(Elite::FVector4), sizeof(Elite::FVector2),
+		sizeof(Elite::RGBColor), sizeof(PackedPosition), sizeof(PackedFrame), sizeof(PackedAttributes) };
+
+	//Header, source path and the submeshes, then the vertex streams and the indices (one run per submesh, the first one cache line aligned)
+	struct CookedMeshHeader
+	{
+		CookedHeader cooked;
+		uint32_t hasColors;
+		uint64_t amountVertices;
+		uint64_t amountIndices;
+		uint64_t streamOffsets[AmountStreams];
+		uint64_t indicesOffset;
+		uint64_t subMeshesOffset; //CookedSubMesh + material name per submesh
+		uint32_t amountSubMeshes;
+		float boundsMin[3];
+		float boundsMax[3];
+	};
+	struct CookedSubMesh
+	{
+		uint32_t firstIndex;
+		uint32_t amountIndices;
+		uint32_t materialSize;
+	};
+
+	const uint32_t g_CookedMagic{ MakeFourCC('M', 'S', 'C', 'K') };
+	const uint32_t g_CookedVersion{ 6 };
+
+	//Vertices are split into the streams this many at a time while cooking
+	const size_t g_VerticesPerBlock{ 64 * 1024 };
+
+	//Every stream but the packed positions, those are quantized over the bounds of the whole mesh once it is parsed
+	struct StreamBuffers
+	{
+		void Append(const Vertex* pVertices, size_t amountVertices)
+		{
+			for (size_t i{}; i < amountVertices; ++i)
+			{
+				const Vertex& vertex{ pVertices[i] };
+				positions.push_back(Elite::FPoint4{ vertex.position.x, vertex.position.y, vertex.position.z, 1.f });
+				normals.push_back(vertex.normal);
+				tangents.push_back(Elite::FVector4{ vertex.tangent, vertex.tangentSign });
+				UVs.push_back(vertex.uv);
+				colors.push_back(vertex.color);
+				packedFrames.push_back(Elite::PackFrame(vertex.normal, vertex.tangent));
+				packedAttributes.push_back(Elite::PackAttributes(vertex.uv, vertex.color));
+				hasColors |= vertex.color.r != 0.f || vertex.color.g != 0.f || vertex.color.b != 0.f;
+			}
+		}
+
+		void Clear()
+		{
+			positions.clear();
+			normals.clear();
+			tangents.clear();
+			UVs.clear();
+			colors.clear();
+			packedFrames.clear();
+			packedAttributes.clear();
+		}
+
+		std::vector<Elite::FPoint4> positions;
+		std::vector<Elite::FVector3> normals;
+		std::vector<Elite::FVector4> tangents;
+		std::vector<Elite::FVector2> UVs;
+		std::vector<Elite::RGBColor> colors;
+		std::vector<PackedFrame> packedFrames;
+		std::vector<PackedAttributes> packedAttributes;
+		bool hasColors{ false };
+	};
+
+	//Grows the bounds by the vertex positions
+	void ExtendBounds(const Vertex* pVertices, size_t amountVertices, Elite::FPoint3& boundsMin, Elite::FPoint3& boundsMax)
+	{
+		for (size_t i{}; i < amountVertices; ++i)
+		{
+			const Elite::FPoint3& position{ pVertices[i].position.xyz };
+			boundsMin = Elite::FPoint3{ std::min(boundsMin.x, position.x), std::min(boundsMin.y, position.y), std::min(boundsMin.z, position.z) };
+			boundsMax = Elite::FPoint3{ std::max(boundsMax.x, position.x), std::max(boundsMax.y, position.y), std::max(boundsMax.z, position.z) };
+		}
+	}
+
+	void PackPositions(const Elite::FPoint4* pPositions, const Elite::FVector4* pTangents, size_t amountVertices, const VertexQuantization& quantization, PackedPosition* pPackedPositions)
+	{
+		for (size_t i{}; i < amountVertices; ++i)
+		{
+			pPackedPositions[i] = Elite::PackPosition(pPositions[i], pTangents[i].w, quantization);
+		}
+	}
+}
+
+//=== Constructor ===//
+MeshCache::MeshCache()
+	: m_MappedFile{}
+	, m_Positions{}
+	, m_Normals{}
+	, m_Tangents{}
+	, m_UVs{}
+	, m_Colors{}
+	, m_PackedPositions{}
+	, m_PackedFrames{}
+	, m_PackedAttributes{}
+	, m_Indices{}
+	, m_Streams{}
+	, m_AmountVertices{}
+	, m_HasColors{}
+	, m_pIndices{ nullptr }
+	, m_AmountIndices{}
+	, m_SubMeshes{}
+	, m_BoundsMin{}
+	, m_BoundsMax{}
+{
+}
+
+//=== Functions ===//
+bool MeshCache::Load(const std::string& filePath, ThreadPool* pThreadPool)
+{
+	const auto start{ std::chrono::high_resolution_clock::now() };
+	if (LoadCooked(filePath))
+	{
+		const std::chrono::duration<double, std::milli> milliseconds{ std::chrono::high_resolution_clock::now() - start };
+		std::cout << filePath << ": " << m_AmountVertices << " vertices mapped from cache in " << milliseconds.count() << " ms" << std::endl;
+		return true;
+	}
+
+	//Cooked while parsing, then mapped like on any later run
+	if (Cook(filePath, pThreadPool) && LoadCooked(filePath))
+	{
+		return true;
+	}
+	return LoadParsed(filePath, pThreadPool);
+}
+
+bool MeshCache::LoadCooked(const std::string& filePath)
+{
+	const int64_t sourceTime{ Elite::GetSourceTime(filePath) };
+	if (sourceTime == 0 || !m_MappedFile.Open(filePath + ".cooked"))
+	{
+		return false;
+	}
+
+	//Anything that doesn't match (older source, other version, truncated file) -> parse the source again
+	const uint8_t* pData{ m_MappedFile.GetData() };
+	const size_t dataSize{ m_MappedFile.GetSize() };
+	CookedMeshHeader header{};
+	if (dataSize >= sizeof(header))
+	{
+		std::memcpy(&header, pData, sizeof(header));
+	}
+
+	bool isValid{ Elite::IsCookedCurrent(header.cooked, g_CookedMagic, g_CookedVersion, sourceTime, filePath, pData, dataSize, sizeof(header))
+		&& header.indicesOffset % Elite::cookedAlignment == 0 && Elite::IsCookedRange(header.indicesOffset, header.amountIndices, sizeof(uint32_t), dataSize) };
+	for (uint32_t stream{}; stream < AmountStreams; ++stream)
+	{
+		isValid = isValid && header.streamOffsets[stream] % Elite::cookedAlignment == 0
+			&& Elite::IsCookedRange(header.streamOffsets[stream], header.amountVertices, g_StreamElementSizes[stream], dataSize);
+	}
+	if (!isValid)
+	{
+		m_MappedFile.Close();
+		return false;
+	}
+
+	//Submeshes are small, copied out of the mapping
+	size_t subMeshOffset{ size_t(header.subMeshesOffset) };
+	for (uint32_t i{}; i < header.amountSubMeshes; ++i)
+	{
+		CookedSubMesh cookedSubMesh{};
+		if (!Elite::IsCookedRange(subMeshOffset, 1, sizeof(cookedSubMesh), dataSize))
+		{
+			break;
+		}
+		std::memcpy(&cookedSubMesh, pData + subMeshOffset, sizeof(cookedSubMesh));
+		subMeshOffset += sizeof(cookedSubMesh);
+		if (!Elite::IsCookedRange(subMeshOffset, cookedSubMesh.materialSize, 1, dataSize) || !Elite::IsCookedRange(cookedSubMesh.firstIndex, cookedSubMesh.amountIndices, 1, size_t(header.amountIndices)))
+		{
+			break;
+		}
+
+		m_SubMeshes.push_back(SubMesh{ std::string(reinterpret_cast<const char*>(pData + subMeshOffset), cookedSubMesh.materialSize), cookedSubMesh.firstIndex, cookedSubMesh.amountIndices });
+		subMeshOffset += cookedSubMesh.materialSize;
+	}
+	if (m_SubMeshes.size() != header.amountSubMeshes)
+	{
+		m_SubMeshes.clear();
+		m_MappedFile.Close();
+		return false;
+	}
+
+	const auto getStream = [pData, &header](CookedStream stream) { return pData + header.streamOffsets[stream]; };
+	m_Streams = MeshStreams{ reinterpret_cast<const Elite::FPoint4*>(getStream(PositionStream)), reinterpret_cast<const Elite::FVector3*>(getStream(NormalStream)),
+		reinterpret_cast<const Elite::FVector4*>(getStream(TangentStream)), reinterpret_cast<const Elite::FVector2*>(getStream(UVStream)),
+		reinterpret_cast<const Elite::RGBColor*>(getStream(ColorStream)), reinterpret_cast<const PackedPosition*>(getStream(PackedPositionStream)),
+		reinterpret_cast<const PackedFrame*>(getStream(PackedFrameStream)), reinterpret_cast<const PackedAttributes*>(getStream(PackedAttributesStream)) };
+	m_AmountVertices = size_t(header.amountVertices);
+	m_HasColors = header.hasColors != 0;
+	m_pIndices = reinterpret_cast<const uint32_t*>(pData + header.indicesOffset);
+	m_AmountIndices = size_t(header.amountIndices);
+	m_BoundsMin = Elite::FPoint3{ header.boundsMin[0], header.boundsMin[1], header.boundsMin[2] };
+	m_BoundsMax = Elite::FPoint3{ header.boundsMax[0], header.boundsMax[1], header.boundsMax[2] };
+	return true;
+}
+
+bool MeshCache::Cook(const std::string& filePath, ThreadPool* pThreadPool) const
+{
+	const int64_t sourceTime{ Elite::GetSourceTime(filePath) };
+	if (sourceTime == 0)
+	{
+		return false;
+	}
+
+	//The header is only known at the end, its place is kept, every stream is a section that grows a block at a time while parsing
+	//and every submesh gets its own index section so all of them can grow at the same time
+	CookedWriter writer{ filePath + ".cooked" };
+	CookedMeshHeader header{ { g_CookedMagic, g_CookedVersion, sourceTime, uint32_t(filePath.size()) } };
+	writer.Write(&header, sizeof(header));
+	writer.Write(filePath.data(), filePath.size());
+	uint32_t streamSections[AmountStreams]{};
+	for (uint32_t& section : streamSections)
+	{
+		section = writer.AddSection(true);
+	}
+
+	Elite::FPoint3 boundsMin{ FLT_MAX, FLT_MAX, FLT_MAX };
+	Elite::FPoint3 boundsMax{ -FLT_MAX, -FLT_MAX, -FLT_MAX };
+	StreamBuffers buffers{};
+	std::vector<uint32_t> indexSections{};
+	Elite::ObjOutput output{};
+	output.addVertices = [&](const Vertex* pVertices, size_t amountVertices)
+	{
+		for (size_t first{}; first < amountVertices; first += g_VerticesPerBlock)
+		{
+			const size_t amountBlock{ std::min(g_VerticesPerBlock, amountVertices - first) };
+			buffers.Clear();
+			buffers.Append(pVertices + first, amountBlock);
+			writer.WriteSection(streamSections[PositionStream], buffers.positions.data(), amountBlock * sizeof(Elite::FPoint4));
+			writer.WriteSection(streamSections[NormalStream], buffers.normals.data(), amountBlock * sizeof(Elite::FVector3));
+			writer.WriteSection(streamSections[TangentStream], buffers.tangents.data(), amountBlock * sizeof(Elite::FVector4));
+			writer.WriteSection(streamSections[UVStream], buffers.UVs.data(), amountBlock * sizeof(Elite::FVector2));
+			writer.WriteSection(streamSections[ColorStream], buffers.colors.data(), amountBlock * sizeof(Elite::RGBColor));
+			writer.WriteSection(streamSections[PackedFrameStream], buffers.packedFrames.data(), amountBlock * sizeof(PackedFrame));
+			writer.WriteSection(streamSections[PackedAttributesStream], buffers.packedAttributes.data(), amountBlock * sizeof(PackedAttributes));
+		}
+		ExtendBounds(pVertices, amountVertices, boundsMin, boundsMax);
+		header.amountVertices += amountVertices;
+	};
+	output.addIndices = [&](uint32_t subMesh, const uint32_t* pIndices, size_t amountIndices)
+	{
+		//Submeshes show up in order, the first index section starts on a cache line and the others continue its array
+		while (indexSections.size() <= subMesh)
+		{
+			indexSections.push_back(writer.AddSection(indexSections.empty()));
+		}
+		writer.WriteSection(indexSections[subMesh], pIndices, amountIndices * sizeof(uint32_t));
+		header.amountIndices += amountIndices;
+	};
+
+	std::vector<SubMesh> subMeshes{};
+	if (!Elite::ParseOBJ(filePath, output, subMeshes, pThreadPool) || header.amountVertices == 0)
+	{
+		return false;
+	}
+
+	//Packed positions from the positions and tangent signs read back a block at a time, now that the bounds are known
+	const VertexQuantization quantization{ Elite::MakeVertexQuantization(boundsMin, boundsMax) };
+	buffers.Clear();
+	std::vector<PackedPosition> packedPositions{};
+	for (size_t first{}; first < header.amountVertices; first += g_VerticesPerBlock)
+	{
+		const size_t amountBlock{ std::min(g_VerticesPerBlock, size_t(header.amountVertices) - first) };
+		buffers.positions.resize(amountBlock);
+		buffers.tangents.resize(amountBlock);
+		packedPositions.resize(amountBlock);
+		if (!writer.ReadSection(streamSections[PositionStream], first * sizeof(Elite::FPoint4), buffers.positions.data(), amountBlock * sizeof(Elite::FPoint4))
+			|| !writer.ReadSection(streamSections[TangentStream], first * sizeof(Elite::FVector4), buffers.tangents.data(), amountBlock * sizeof(Elite::FVector4)))
+		{
+			return false;
+		}
+		PackPositions(buffers.positions.data(), buffers.tangents.data(), amountBlock, quantization, packedPositions.data());
+		writer.WriteSection(streamSections[PackedPositionStream], packedPositions.data(), amountBlock * sizeof(PackedPosition));
+	}
+
+	header.subMeshesOffset = writer.GetSize();
+	header.amountSubMeshes = uint32_t(subMeshes.size());
+	for (const SubMesh& subMesh : subMeshes)
+	{
+		const CookedSubMesh cookedSubMesh{ subMesh.firstIndex, subMesh.amountIndices, uint32_t(subMesh.material.size()) };
+		writer.Write(&cookedSubMesh, sizeof(cookedSubMesh));
+		writer.Write(subMesh.material.data(), subMesh.material.size());
+	}
+	for (uint32_t stream{}; stream < AmountStreams; ++stream)
+	{
+		header.streamOffsets[stream] = writer.GetSectionOffset(streamSections[stream]);
+	}
+	header.indicesOffset = indexSections.empty() ? 0 : writer.GetSectionOffset(indexSections[0]);
+	header.hasColors = buffers.hasColors ? 1 : 0;
+	std::copy_n(boundsMin.data, 3, header.boundsMin);
+	std::copy_n(boundsMax.data, 3, header.boundsMax);
+	writer.WriteAt(0, &header, sizeof(header));
+
+	//Written next to the source, a failed write only costs parsing into memory
+	if (!writer.Commit())
+	{
+		std::cout << "Mesh not cooked properly." << std::endl;
+		return false;
+	}
+	return true;
+}
+
+bool MeshCache::LoadParsed(const std::string& filePath, ThreadPool* pThreadPool)
+{
+	StreamBuffers buffers{};
+	std::vector<std::vector<uint32_t>> subMeshIndices{};
+	Elite::ObjOutput output{};
+	output.addVertices = [&](const Vertex* pVertices, size_t amountVertices)
+	{
+		if (buffers.positions.empty())
+		{
+			m_BoundsMin = m_BoundsMax = pVertices[0].position.xyz;
+		}
+		buffers.Append(pVertices, amountVertices);
+		ExtendBounds(pVertices, amountVertices, m_BoundsMin, m_BoundsMax);
+	};
+	output.addIndices = [&subMeshIndices](uint32_t subMesh, const uint32_t* pIndices, size_t amountIndices)
+	{
+		subMeshIndices.resize(std::max(subMeshIndices.size(), size_t(subMesh) + 1));
+		subMeshIndices[subMesh].insert(subMeshIndices[subMesh].end(), pIndices, pIndices + amountIndices);
+	};
+
+	if (!Elite::ParseOBJ(filePath, output, m_SubMeshes, pThreadPool))
+	{
+		return false;
+	}
+
+	m_Indices.clear();
+	for (std::vector<uint32_t>& indices : subMeshIndices)
+	{
+		m_Indices.insert(m_Indices.end(), indices.begin(), indices.end());
+		std::vector<uint32_t>{}.swap(indices);
+	}
+
+	m_Positions = std::move(buffers.positions);
+	m_Normals = std::move(buffers.normals);
+	m_Tangents = std::move(buffers.tangents);
+	m_UVs = std::move(buffers.UVs);
+	m_Colors = std::move(buffers.colors);
+	m_PackedFrames = std::move(buffers.packedFrames);
+	m_PackedAttributes = std::move(buffers.packedAttributes);
+	m_PackedPositions.resize(m_Positions.size());
+	PackPositions(m_Positions.data(), m_Tangents.data(), m_Positions.size(), Elite::MakeVertexQuantization(m_BoundsMin, m_BoundsMax), m_PackedPositions.data());
+
+	m_Streams = MeshStreams{ m_Positions.data(), m_Normals.data(), m_Tangents.data(), m_UVs.data(), m_Colors.data(),
+		m_PackedPositions.data(), m_PackedFrames.data(), m_PackedAttributes.data() };
+	m_AmountVertices = m_Positions.size();
+	m_HasColors = buffers.hasColors;
+	m_pIndices = m_Indices.data();
+	m_AmountIndices = m_Indices.size();
+	return true;
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "EMath.h"
+#include "ERGBColor.h"
+#include "Vertex.h"
+#include "PackedVertex.h"
+#include "MappedFile.h"
+#include "SubMesh.h"
+
+class ThreadPool;
+
+//=== MeshStreams struct ===//
+//Vertices split per attribute (SoA), full precision and packed over the mesh bounds, every stream has one element per vertex
+struct MeshStreams
+{
+	const Elite::FPoint4* pPositions; //w = 1
+	const Elite::FVector3* pNormals;
+	const Elite::FVector4* pTangents; //w = tangent sign
+	const Elite::FVector2* pUVs;
+	const Elite::RGBColor* pColors;
+	const PackedPosition* pPackedPositions;
+	const PackedFrame* pPackedFrames;
+	const PackedAttributes* pPackedAttributes;
+};
+
+//=== MeshCache class ===//
+//Final vertex streams and index stream of an OBJ, cooked next to the source (<path>.cooked) and memory mapped
+//Streams and indices point straight into the mapping, the cache has to outlive every mesh built from it
+class MeshCache final
+{
+public:
+	//=== Constructor ===//
+	MeshCache();
+
+	//=== Rule of five ===//
+	~MeshCache() = default;
+	MeshCache(const MeshCache& meshCache) = delete;
+	MeshCache(MeshCache&& meshCache) = delete;
+	MeshCache& operator=(const MeshCache& meshCache) = delete;
+	MeshCache& operator=(MeshCache&& meshCache) = delete;
+
+	//=== Functions ===//
+	//Maps the cooked file when it is up to date, otherwise parses the OBJ straight into a new cooked file and maps that
+	//Only when the cooked file can't be written the OBJ is parsed into memory
+	bool Load(const std::string& filePath, ThreadPool* pThreadPool = nullptr);
+
+	const MeshStreams& GetStreams() const { return m_Streams; }
+	size_t GetAmountVertices() const { return m_AmountVertices; }
+	bool HasColors() const { return m_HasColors; } //False when every vertex color is black
+	const uint32_t* GetIndices() const { return m_pIndices; }
+	size_t GetAmountIndices() const { return m_AmountIndices; }
+	const std::vector<SubMesh>& GetSubMeshes() const { return m_SubMeshes; }
+
+	const Elite::FPoint3& GetBoundsMin() const { return m_BoundsMin; }
+	const Elite::FPoint3& GetBoundsMax() const { return m_BoundsMax; }
+
+private:
+	//=== Functions ===//
+	bool LoadCooked(const std::string& filePath);
+	bool Cook(const std::string& filePath, ThreadPool* pThreadPool) const;
+	bool LoadParsed(const std::string& filePath, ThreadPool* pThreadPool);
+
+	//=== Variables ===//
+	//Parsed data lives in the vectors, cooked data in the mapping
+	MappedFile m_MappedFile;
+	std::vector<Elite::FPoint4> m_Positions;
+	std::vector<Elite::FVector3> m_Normals;
+	std::vector<Elite::FVector4> m_Tangents;
+	std::vector<Elite::FVector2> m_UVs;
+	std::vector<Elite::RGBColor> m_Colors;
+	std::vector<PackedPosition> m_PackedPositions;
+	std::vector<PackedFrame> m_PackedFrames;
+	std::vector<PackedAttributes> m_PackedAttributes;
+	std::vector<uint32_t> m_Indices;
+
+	MeshStreams m_Streams;
+	size_t m_AmountVertices;
+	bool m_HasColors;
+	const uint32_t* m_pIndices;
+	size_t m_AmountIndices;
+	std::vector<SubMesh> m_SubMeshes;
+
+	Elite::FPoint3 m_BoundsMin;
+	Elite::FPoint3 m_BoundsMax;
+};
@@ -0,0 +1,185 @@
+#include "pch.h"
+
+#include <cmath>
+#include <cstring>
+
+#include "PackedVertex.h"
+
+//=== Helpers ===//
+namespace
+{
+	inline uint16_t ToUNorm16(float value)
+	{
+		return uint16_t(std::lround(Elite::Clamp(value, 0.f, 1.f) * 65535.f));
+	}
+
+	inline int16_t ToSNorm16(float value)
+	{
+		return int16_t(std::lround(Elite::Clamp(value, -1.f, 1.f) * 32767.f));
+	}
+
+	inline float FromSNorm16(int16_t value)
+	{
+		//Same as D3D, -32768 and -32767 both map to -1
+		return std::max(float(value) / 32767.f, -1.f);
+	}
+
+	inline uint32_t ToUNorm8(float value)
+	{
+		return uint32_t(std::lround(Elite::Clamp(value, 0.f, 1.f) * 255.f));
+	}
+
+	//Octahedral mapping, the unit sphere folded onto [-1, 1]^2 (uniform precision over all directions)
+	inline Elite::FVector2 EncodeOctahedral(const Elite::FVector3& direction)
+	{
+		const float length{ std::abs(direction.x) + std::abs(direction.y) + std::abs(direction.z) };
+		if (length == 0.f)
+		{
+			return Elite::FVector2{};
+		}
+
+		Elite::FVector2 encoded{ direction.x / length, direction.y / length };
+		if (direction.z < 0.f)
+		{
+			encoded = Elite::FVector2{ (1.f - std::abs(encoded.y)) * (encoded.x >= 0.f ? 1.f : -1.f), (1.f - std::abs(encoded.x)) * (encoded.y >= 0.f ? 1.f : -1.f) };
+		}
+		return encoded;
+	}
+
+	inline Elite::FVector3 DecodeOctahedral(float x, float y)
+	{
+		Elite::FVector3 direction{ x, y, 1.f - std::abs(x) - std::abs(y) };
+		const float fold{ std::max(-direction.z, 0.f) };
+		direction.x += (direction.x >= 0.f) ? -fold : fold;
+		direction.y += (direction.y >= 0.f) ? -fold : fold;
+		return Elite::GetNormalized(direction);
+	}
+
+	//IEEE half, rounded to nearest, overflow goes to infinity
+	uint16_t FloatToHalf(float value)
+	{
+		uint32_t bits{};
+		std::memcpy(&bits, &value, sizeof(bits));
+
+		const uint32_t sign{ (bits >> 16) & 0x8000u };
+		const int32_t exponent{ int32_t((bits >> 23) & 0xFFu) - 127 + 15 };
+		uint32_t mantissa{ bits & 0x7FFFFFu };
+
+		if (((bits >> 23) & 0xFFu) == 0xFFu)
+		{
+			return uint16_t(sign | 0x7C00u | (mantissa ? 0x200u : 0u));
+		}
+		if (exponent >= 31)
+		{
+			return uint16_t(sign | 0x7C00u);
+		}
+		if (exponent <= 0)
+		{
+			//Subnormal (or too small -> signed zero)
+			if (exponent < -10)
+			{
+				return uint16_t(sign);
+			}
+			mantissa |= 0x800000u;
+			const uint32_t shift{ uint32_t(14 - exponent) };
+			const uint32_t half{ (mantissa >> shift) + ((mantissa >> (shift - 1)) & 1u) };
+			return uint16_t(sign | half);
+		}
+
+		//A rounding carry runs into the exponent, which is exactly right
+		const uint32_t half{ (sign | (uint32_t(exponent) << 10) | (mantissa >> 13)) + ((mantissa >> 12) & 1u) };
+		return uint16_t(half);
+	}
+
+	float HalfToFloat(uint16_t half)
+	{
+		const uint32_t sign{ uint32_t(half & 0x8000u) << 16 };
+		uint32_t exponent{ (half >> 10) & 0x1Fu };
+		uint32_t mantissa{ half & 0x3FFu };
+
+		uint32_t bits{};
+		if (exponent == 0x1Fu)
+		{
+			bits = sign | 0x7F800000u | (mantissa << 13);
+		}
+		else if (exponent != 0)
+		{
+			bits = sign | ((exponent + 112) << 23) | (mantissa << 13);
+		}
+		else if (mantissa != 0)
+		{
+			//Subnormal, normalize it
+			exponent = 113;
+			while (!(mantissa & 0x400u))
+			{
+				mantissa <<= 1;
+				--exponent;
+			}
+			bits = sign | (exponent << 23) | ((mantissa & 0x3FFu) << 13);
+		}
+		else
+		{
+			bits = sign;
+		}
+
+		float value{};
+		std::memcpy(&value, &bits, sizeof(value));
+		return value;
+	}
+}
+
+//=== Functions ===//
+VertexQuantization Elite::MakeVertexQuantization(const FPoint3& boundsMin, const FPoint3& boundsMax)
+{
+	return VertexQuantization{ boundsMin, FVector3{ boundsMax - boundsMin } };
+}
+
+PackedPosition Elite::PackPosition(const FPoint4& position, float tangentSign, const VertexQuantization& quantization)
+{
+	//Flat axes (scale 0) quantize to 0, they decode to the offset anyway
+	const auto quantize = [](float value, float offset, float scale) { return (scale > 0.f) ? ToUNorm16((value - offset) / scale) : uint16_t{}; };
+
+	PackedPosition packedPosition{};
+	packedPosition.components[0] = quantize(position.x, quantization.offset.x, quantization.scale.x);
+	packedPosition.components[1] = quantize(position.y, quantization.offset.y, quantization.scale.y);
+	packedPosition.components[2] = quantize(position.z, quantization.offset.z, quantization.scale.z);
+	packedPosition.components[3] = (tangentSign < 0.f) ? 0 : 65535;
+	return packedPosition;
+}
+
+PackedFrame Elite::PackFrame(const FVector3& normal, const FVector3& tangent)
+{
+	const FVector2 encodedNormal{ EncodeOctahedral(normal) };
+	const FVector2 encodedTangent{ EncodeOctahedral(tangent) };
+	return PackedFrame{ { ToSNorm16(encodedNormal.x), ToSNorm16(encodedNormal.y), ToSNorm16(encodedTangent.x), ToSNorm16(encodedTangent.y) } };
+}
+
+PackedAttributes Elite::PackAttributes(const FVector2& uv, const RGBColor& color)
+{
+	return PackedAttributes{ { FloatToHalf(uv.x), FloatToHalf(uv.y) }, ToUNorm8(color.r) | (ToUNorm8(color.g) << 8) | (ToUNorm8(color.b) << 16) | (255u << 24) };
+}
+
+Elite::FPoint4 Elite::UnpackPosition(const PackedPosition& packedPosition, const VertexQuantization& quantization)
+{
+	const float toUnit{ 1.f / 65535.f };
+	return FPoint4{ quantization.offset.x + float(packedPosition.components[0]) * toUnit * quantization.scale.x,
+		quantization.offset.y + float(packedPosition.components[1]) * toUnit * quantization.scale.y,
+		quantization.offset.z + float(packedPosition.components[2]) * toUnit * quantization.scale.z, 1.f };
+}
+
+void Elite::UnpackFrame(const PackedFrame& packedFrame, FVector3& normal, FVector3& tangent)
+{
+	normal = DecodeOctahedral(FromSNorm16(packedFrame.components[0]), FromSNorm16(packedFrame.components[1]));
+	tangent = DecodeOctahedral(FromSNorm16(packedFrame.components[2]), FromSNorm16(packedFrame.components[3]));
+}
+
+float Elite::UnpackTangentSign(const PackedPosition& packedPosition)
+{
+	return (packedPosition.components[3] != 0) ? 1.f : -1.f;
+}
+
+void Elite::UnpackAttributes(const PackedAttributes& packedAttributes, FVector2& uv, RGBColor& color)
+{
+	uv = FVector2{ HalfToFloat(packedAttributes.uv[0]), HalfToFloat(packedAttributes.uv[1]) };
+	color = RGBColor{ float(packedAttributes.color & 0xFFu) / 255.f, float((packedAttributes.color >> 8) & 0xFFu) / 255.f, float((packedAttributes.color >> 16) & 0xFFu) / 255.f };
+}
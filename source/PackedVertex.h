@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstdint>
+
+#include "EMath.h"
+#include "ERGBColor.h"
+
+//=== PackedPosition, PackedFrame and PackedAttributes structs ===//
+//A quantized vertex, 24 bytes instead of 64, kept as three streams: the software vertex stage reads positions every frame and frames only
+//for visible vertices, hardware binds each stream to its own input slot and decodes them in the input layout + packed vertex shader
+struct PackedPosition
+{
+	uint16_t components[4]; //UNORM over the mesh bounds, w holds the tangent sign (0 -> -1, 65535 -> 1) (POSITION)
+};
+
+struct PackedFrame
+{
+	int16_t components[4]; //SNORM octahedral normal (xy) and tangent (zw) (NORMAL)
+};
+
+struct PackedAttributes
+{
+	uint16_t uv[2]; //Half floats (TEXCOORD)
+	uint32_t color; //RGBA8 UNORM, alpha unused (COLOR)
+};
+
+//=== VertexQuantization struct ===//
+//Maps the [0, 1] positions of packed vertices back to model space: position = offset + quantized * scale
+struct VertexQuantization
+{
+	Elite::FPoint3 offset; //Bounds minimum
+	Elite::FVector3 scale; //Bounds extent
+};
+
+namespace Elite
+{
+	//=== Functions ===//
+	VertexQuantization MakeVertexQuantization(const FPoint3& boundsMin, const FPoint3& boundsMax);
+
+	PackedPosition PackPosition(const FPoint4& position, float tangentSign, const VertexQuantization& quantization);
+	PackedFrame PackFrame(const FVector3& normal, const FVector3& tangent);
+	PackedAttributes PackAttributes(const FVector2& uv, const RGBColor& color);
+
+	//Position, normal and tangent are what the vertex stage transforms, the rest is decoded once
+	FPoint4 UnpackPosition(const PackedPosition& packedPosition, const VertexQuantization& quantization);
+	void UnpackFrame(const PackedFrame& packedFrame, FVector3& normal, FVector3& tangent);
+	float UnpackTangentSign(const PackedPosition& packedPosition);
+	void UnpackAttributes(const PackedAttributes& packedAttributes, FVector2& uv, RGBColor& color);
+}
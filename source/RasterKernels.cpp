@@ -0,0 +1,247 @@
+#include "pch.h"
+
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define TARGET_AVX2
+#else
+#include <cpuid.h>
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+#include "RasterKernels.h"
+
+//=== Functions ===//
+//- Scalar (reference) -//
+uint32_t Elite::RasterizeSpanScalar(const TriangleSetup& setup, const int32_t startEdges[3], uint32_t count, float* pDepth, PixelBatch& batch)
+{
+	const int32_t step0{ setup.edges[0].a * EdgeFunction::subPixelScale };
+	const int32_t step1{ setup.edges[1].a * EdgeFunction::subPixelScale };
+	const int32_t step2{ setup.edges[2].a * EdgeFunction::subPixelScale };
+
+	uint32_t mask{};
+	int32_t edge0{ startEdges[0] }, edge1{ startEdges[1] }, edge2{ startEdges[2] };
+
+	for (uint32_t i{}; i < count; ++i, edge0 += step0, edge1 += step1, edge2 += step2)
+	{
+		//Pixel in triangle (hit) check, inside when no edge value is negative
+		if ((edge0 | edge1 | edge2) < 0)
+		{
+			continue;
+		}
+
+		//Depth check and calculation
+		const float weight0{ float(edge0) * setup.invArea };
+		const float weight1{ float(edge1) * setup.invArea };
+		const float weight2{ float(edge2) * setup.invArea };
+		if (setup.pTriangle->Depth(pDepth[i], batch.wInterpolated[i], weight0, weight1, weight2))
+		{
+			batch.weight0[i] = weight0;
+			batch.weight1[i] = weight1;
+			batch.weight2[i] = weight2;
+			mask |= 1u << i;
+		}
+	}
+
+	return mask;
+}
+
+//- SSE (2 x 4 pixels) -//
+uint32_t Elite::RasterizeSpanSSE(const TriangleSetup& setup, const int32_t startEdges[3], uint32_t count, float* pDepth, PixelBatch& batch)
+{
+	const __m128 one{ _mm_set1_ps(1.f) };
+	const __m128 invArea{ _mm_set1_ps(setup.invArea) };
+	const __m128i allOnes{ _mm_set1_epi32(-1) };
+
+	const int32_t step0{ setup.edges[0].a * EdgeFunction::subPixelScale };
+	const int32_t step1{ setup.edges[1].a * EdgeFunction::subPixelScale };
+	const int32_t step2{ setup.edges[2].a * EdgeFunction::subPixelScale };
+	uint32_t mask{};
+
+	for (uint32_t half{}; half < 2 && half * 4 < count; ++half)
+	{
+		const int32_t offset{ int32_t(half * 4) };
+		const uint32_t halfCount{ std::min(count - offset, 4u) };
+
+		//Coverage, integer edge values stepped per lane
+		const __m128i edge0{ _mm_add_epi32(_mm_set1_epi32(startEdges[0] + offset * step0), _mm_setr_epi32(0, step0, 2 * step0, 3 * step0)) };
+		const __m128i edge1{ _mm_add_epi32(_mm_set1_epi32(startEdges[1] + offset * step1), _mm_setr_epi32(0, step1, 2 * step1, 3 * step1)) };
+		const __m128i edge2{ _mm_add_epi32(_mm_set1_epi32(startEdges[2] + offset * step2), _mm_setr_epi32(0, step2, 2 * step2, 3 * step2)) };
+
+		__m128i inside{ _mm_cmpgt_epi32(_mm_or_si128(_mm_or_si128(edge0, edge1), edge2), allOnes) };
+		if (halfCount < 4)
+		{
+			inside = _mm_and_si128(inside, _mm_cmplt_epi32(_mm_setr_epi32(0, 1, 2, 3), _mm_set1_epi32(int32_t(halfCount))));
+		}
+		if (_mm_movemask_ps(_mm_castsi128_ps(inside)) == 0)
+		{
+			continue;
+		}
+
+		//Barycentric weights
+		const __m128 weight0{ _mm_mul_ps(_mm_cvtepi32_ps(edge0), invArea) };
+		const __m128 weight1{ _mm_mul_ps(_mm_cvtepi32_ps(edge1), invArea) };
+		const __m128 weight2{ _mm_mul_ps(_mm_cvtepi32_ps(edge2), invArea) };
+
+		//Perspective correct depth and w
+		const __m128 invZ{ _mm_add_ps(_mm_add_ps(_mm_mul_ps(weight0, _mm_set1_ps(setup.invZ[0])), _mm_mul_ps(weight1, _mm_set1_ps(setup.invZ[1]))), _mm_mul_ps(weight2, _mm_set1_ps(setup.invZ[2]))) };
+		const __m128 invW{ _mm_add_ps(_mm_add_ps(_mm_mul_ps(weight0, _mm_set1_ps(setup.invW[0])), _mm_mul_ps(weight1, _mm_set1_ps(setup.invW[1]))), _mm_mul_ps(weight2, _mm_set1_ps(setup.invW[2]))) };
+		const __m128 z{ _mm_div_ps(one, invZ) };
+		const __m128 w{ _mm_div_ps(one, invW) };
+
+		//Depth test, partial spans go through a local copy so nothing past count gets touched
+		float localDepth[4]{ FLT_MAX, FLT_MAX, FLT_MAX, FLT_MAX };
+		float* pHalfDepth{ halfCount == 4 ? pDepth + offset : localDepth };
+		if (halfCount < 4)
+		{
+			std::copy(pDepth + offset, pDepth + offset + halfCount, localDepth);
+		}
+
+		const __m128 depth{ _mm_loadu_ps(pHalfDepth) };
+		const __m128 pass{ _mm_and_ps(_mm_castsi128_ps(inside), _mm_cmplt_ps(z, depth)) };
+		const int passMask{ _mm_movemask_ps(pass) };
+		if (passMask == 0)
+		{
+			continue;
+		}
+
+		//Masked depth write
+		_mm_storeu_ps(pHalfDepth, _mm_or_ps(_mm_and_ps(pass, z), _mm_andnot_ps(pass, depth)));
+		if (halfCount < 4)
+		{
+			std::copy(localDepth, localDepth + halfCount, pDepth + offset);
+		}
+
+		_mm_storeu_ps(batch.weight0 + offset, weight0);
+		_mm_storeu_ps(batch.weight1 + offset, weight1);
+		_mm_storeu_ps(batch.weight2 + offset, weight2);
+		_mm_storeu_ps(batch.wInterpolated + offset, w);
+		mask |= uint32_t(passMask) << offset;
+	}
+
+	return mask;
+}
+
+//- AVX2 (8 pixels) -//
+TARGET_AVX2 uint32_t Elite::RasterizeSpanAVX2(const TriangleSetup& setup, const int32_t startEdges[3], uint32_t count, float* pDepth, PixelBatch& batch)
+{
+	const __m256 one{ _mm256_set1_ps(1.f) };
+	const __m256 invArea{ _mm256_set1_ps(setup.invArea) };
+	const __m256i laneIndices{ _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7) };
+
+	//Coverage, integer edge values stepped per lane
+	const __m256i edge0{ _mm256_add_epi32(_mm256_set1_epi32(startEdges[0]), _mm256_mullo_epi32(_mm256_set1_epi32(setup.edges[0].a * EdgeFunction::subPixelScale), laneIndices)) };
+	const __m256i edge1{ _mm256_add_epi32(_mm256_set1_epi32(startEdges[1]), _mm256_mullo_epi32(_mm256_set1_epi32(setup.edges[1].a * EdgeFunction::subPixelScale), laneIndices)) };
+	const __m256i edge2{ _mm256_add_epi32(_mm256_set1_epi32(startEdges[2]), _mm256_mullo_epi32(_mm256_set1_epi32(setup.edges[2].a * EdgeFunction::subPixelScale), laneIndices)) };
+
+	const __m256i countMask{ _mm256_cmpgt_epi32(_mm256_set1_epi32(int(count)), laneIndices) };
+	const __m256i inside{ _mm256_and_si256(_mm256_cmpgt_epi32(_mm256_or_si256(_mm256_or_si256(edge0, edge1), edge2), _mm256_set1_epi32(-1)), countMask) };
+	if (_mm256_movemask_ps(_mm256_castsi256_ps(inside)) == 0)
+	{
+		return 0;
+	}
+
+	//Barycentric weights
+	const __m256 weight0{ _mm256_mul_ps(_mm256_cvtepi32_ps(edge0), invArea) };
+	const __m256 weight1{ _mm256_mul_ps(_mm256_cvtepi32_ps(edge1), invArea) };
+	const __m256 weight2{ _mm256_mul_ps(_mm256_cvtepi32_ps(edge2), invArea) };
+
+	//Perspective correct depth and w
+	const __m256 invZ{ _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(weight0, _mm256_set1_ps(setup.invZ[0])), _mm256_mul_ps(weight1, _mm256_set1_ps(setup.invZ[1]))), _mm256_mul_ps(weight2, _mm256_set1_ps(setup.invZ[2]))) };
+	const __m256 invW{ _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(weight0, _mm256_set1_ps(setup.invW[0])), _mm256_mul_ps(weight1, _mm256_set1_ps(setup.invW[1]))), _mm256_mul_ps(weight2, _mm256_set1_ps(setup.invW[2]))) };
+	const __m256 z{ _mm256_div_ps(one, invZ) };
+	const __m256 w{ _mm256_div_ps(one, invW) };
+
+	//Depth test, loads and stores are masked so nothing past count gets touched
+	const __m256 depth{ _mm256_maskload_ps(pDepth, countMask) };
+	const __m256 pass{ _mm256_and_ps(_mm256_castsi256_ps(inside), _mm256_cmp_ps(z, depth, _CMP_LT_OQ)) };
+	const int passMask{ _mm256_movemask_ps(pass) };
+	if (passMask == 0)
+	{
+		return 0;
+	}
+
+	//Masked depth write
+	_mm256_maskstore_ps(pDepth, _mm256_castps_si256(pass), z);
+
+	_mm256_storeu_ps(batch.weight0, weight0);
+	_mm256_storeu_ps(batch.weight1, weight1);
+	_mm256_storeu_ps(batch.weight2, weight2);
+	_mm256_storeu_ps(batch.wInterpolated, w);
+
+	return uint32_t(passMask);
+}
+
+//- Dispatch -//
+bool Elite::IsRasterKernelSupported(RasterKernel kernel)
+{
+	switch (kernel)
+	{
+	case RasterKernel::Scalar:
+	case RasterKernel::SSE:
+		//SSE2 is part of x64
+		return true;
+
+	case RasterKernel::AVX2:
+	{
+#if defined(_MSC_VER)
+		int info[4]{};
+		__cpuid(info, 0);
+		if (info[0] < 7)
+		{
+			return false;
+		}
+
+		//AVX has to be enabled by the OS too (ymm registers saved on context switch)
+		__cpuid(info, 1);
+		const bool hasOSXSave{ (info[2] & (1 << 27)) != 0 };
+		const bool hasAVX{ (info[2] & (1 << 28)) != 0 };
+		if (!hasOSXSave || !hasAVX || (_xgetbv(0) & 0x6) != 0x6)
+		{
+			return false;
+		}
+
+		__cpuidex(info, 7, 0);
+		return (info[1] & (1 << 5)) != 0;
+#else
+		return __builtin_cpu_supports("avx2");
+#endif
+	}
+
+	default:
+		return false;
+	}
+}
+
+Elite::RasterKernel Elite::GetFastestRasterKernel()
+{
+	//Checked once, the CPU doesn't change while running
+	static const RasterKernel fastestKernel{ IsRasterKernelSupported(RasterKernel::AVX2) ? RasterKernel::AVX2 : RasterKernel::SSE };
+	return fastestKernel;
+}
+
+Elite::SpanKernel Elite::GetSpanKernel(RasterKernel kernel)
+{
+	switch (kernel)
+	{
+	case RasterKernel::AVX2:
+		return &RasterizeSpanAVX2;
+	case RasterKernel::SSE:
+		return &RasterizeSpanSSE;
+	default:
+		return &RasterizeSpanScalar;
+	}
+}
+
+const char* Elite::GetRasterKernelName(RasterKernel kernel)
+{
+	switch (kernel)
+	{
+	case RasterKernel::AVX2:
+		return "AVX2";
+	case RasterKernel::SSE:
+		return "SSE";
+	default:
+		return "scalar";
+	}
+}
\ No newline at end of file
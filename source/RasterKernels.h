@@ -0,0 +1,59 @@
+#pragma once
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+#include "Triangle.h"
+
+//=== PixelBatch struct ===//
+//Per pixel results of one span (up to 8 pixels of a row)
+struct PixelBatch
+{
+	//=== Variables ===//
+	static constexpr uint32_t size{ 8 };
+
+	float weight0[size];
+	float weight1[size];
+	float weight2[size];
+	float wInterpolated[size];
+};
+
+namespace Elite
+{
+	//=== RasterKernel enum class ===//
+	enum class RasterKernel
+	{
+		Scalar = 0,
+		SSE = 1,
+		AVX2 = 2,
+		Count = 3,
+	};
+
+	//Tests coverage, does the depth test and writes depth for count (<= 8) pixels starting at the fixed point edge values startEdges,
+	//returns a mask with a bit set for every pixel that has to be shaded
+	typedef uint32_t(*SpanKernel)(const TriangleSetup& setup, const int32_t startEdges[3], uint32_t count, float* pDepth, PixelBatch& batch);
+
+	//=== Functions ===//
+	uint32_t RasterizeSpanScalar(const TriangleSetup& setup, const int32_t startEdges[3], uint32_t count, float* pDepth, PixelBatch& batch);
+	uint32_t RasterizeSpanSSE(const TriangleSetup& setup, const int32_t startEdges[3], uint32_t count, float* pDepth, PixelBatch& batch);
+	uint32_t RasterizeSpanAVX2(const TriangleSetup& setup, const int32_t startEdges[3], uint32_t count, float* pDepth, PixelBatch& batch);
+
+	//Runtime dispatch
+	bool IsRasterKernelSupported(RasterKernel kernel);
+	RasterKernel GetFastestRasterKernel();
+	SpanKernel GetSpanKernel(RasterKernel kernel);
+	const char* GetRasterKernelName(RasterKernel kernel);
+
+	//Index of the lowest set bit, mask can't be 0
+	inline uint32_t LowestBitIndex(uint32_t mask)
+	{
+#if defined(_MSC_VER)
+		unsigned long index{};
+		_BitScanForward(&index, mask);
+		return uint32_t(index);
+#else
+		return uint32_t(__builtin_ctz(mask));
+#endif
+	}
+}
\ No newline at end of file
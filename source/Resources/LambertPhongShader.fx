@@ -18,6 +18,10 @@ float gPi = 3.14159265358979323846264338327950288419716939937510f;
 float gLightIntensity = 7.0f;
 float gShininess = 25.0f;
 
+//Packed vertices only: position = gPositionOffset + quantized position * gPositionScale
+float3 gPositionOffset = float3(0.0f, 0.0f, 0.0f);
+float3 gPositionScale = float3(1.0f, 1.0f, 1.0f);
+
 //-----------------------------------------------//
 // Sampler States
 //-----------------------------------------------//
@@ -99,7 +103,14 @@ struct VS_INPUT
 	float3 Color : COLOR;
 	float2 TexCoord : TEXCOORD;
 	float3 Normal : NORMAL;
-	float3 Tangent : TANGENT;
+	float4 Tangent : TANGENT; //w = handedness
+};
+struct VS_PACKED_INPUT
+{
+	float4 Position : POSITION; //[0, 1] over the mesh bounds, w = tangent sign (0 or 1)
+	float4 NormalTangent : NORMAL; //Octahedral normal (xy) and tangent (zw)
+	float2 TexCoord : TEXCOORD;
+	float4 Color : COLOR;
 };
 struct VS_OUTPUT
 {
@@ -107,7 +118,7 @@ struct VS_OUTPUT
 	float4 WorldPosition : COLOR;
 	float2 TexCoord : TEXCOORD;
 	float3 Normal : NORMAL;
-	float3 Tangent : TANGENT;
+	float4 Tangent : TANGENT; //w = handedness
 };
 
 //-----------------------------------------------//
@@ -120,11 +131,30 @@ VS_OUTPUT VS(VS_INPUT input)
 	output.WorldPosition = mul(float4(input.Position, 1.0f), gWorld);
 	output.TexCoord = input.TexCoord;
 	output.Normal = mul(normalize(input.Normal), (float3x3)gWorld);
-	output.Tangent = mul(normalize(input.Tangent), (float3x3)gWorld);
+	output.Tangent = float4(mul(normalize(input.Tangent.xyz), (float3x3)gWorld), input.Tangent.w);
 	
 	return output;
 }
 
+float3 DecodeOctahedral(float2 encoded)
+{
+	float3 direction = float3(encoded, 1.0f - abs(encoded.x) - abs(encoded.y));
+	float fold = saturate(-direction.z);
+	direction.xy += (direction.xy >= 0.0f) ? -fold : fold;
+	return normalize(direction);
+}
+
+VS_OUTPUT VSPacked(VS_PACKED_INPUT input)
+{
+	VS_INPUT unpacked = (VS_INPUT)0;
+	unpacked.Position = gPositionOffset + input.Position.xyz * gPositionScale;
+	unpacked.Color = input.Color.rgb;
+	unpacked.TexCoord = input.TexCoord;
+	unpacked.Normal = DecodeOctahedral(input.NormalTangent.xy);
+	unpacked.Tangent = float4(DecodeOctahedral(input.NormalTangent.zw), input.Position.w * 2.0f - 1.0f);
+	return VS(unpacked);
+}
+
 //-----------------------------------------------//
 // Pixel Shader
 //-----------------------------------------------//
@@ -136,8 +166,9 @@ float4 ShadePixelLP(VS_OUTPUT input, SamplerState sampleState)
 	//Normal
 	float4 normalMapSample = gNormalMap.Sample(sampleState, input.TexCoord);
 	normalMapSample = (normalMapSample * 2.0f) - float4(1.0f, 1.0f, 1.0f, 1.0f);
-	float3 biNormal = cross(input.Normal, input.Tangent);
-	float3x3 tangentSpaceAxis = float3x3(input.Tangent, biNormal, input.Normal);
+	normalMapSample.z = sqrt(saturate(1.0f - dot(normalMapSample.xy, normalMapSample.xy))); //Two channel (BC5) normal maps don't store z
+	float3 biNormal = cross(input.Normal, input.Tangent.xyz) * (input.Tangent.w < 0.0f ? -1.0f : 1.0f);
+	float3x3 tangentSpaceAxis = float3x3(input.Tangent.xyz, biNormal, input.Normal);
 	float3 newNormal = normalize(mul(normalMapSample.xyz, tangentSpaceAxis));
 	
 	//Diffuse
@@ -180,8 +211,9 @@ float4 ShadePixelLP2(VS_OUTPUT input, SamplerState sampleState)
 	//Normal
 	float4 normalMapSample = gNormalMap.Sample(sampleState, input.TexCoord);
 	normalMapSample = (normalMapSample * 2.0f) - float4(1.0f, 1.0f, 1.0f, 1.0f);
-	float3 biNormal = cross(input.Normal, input.Tangent);
-	float3x3 tangentSpaceAxis = float3x3(input.Tangent, biNormal, input.Normal);
+	normalMapSample.z = sqrt(saturate(1.0f - dot(normalMapSample.xy, normalMapSample.xy))); //Two channel (BC5) normal maps don't store z
+	float3 biNormal = cross(input.Normal, input.Tangent.xyz) * (input.Tangent.w < 0.0f ? -1.0f : 1.0f);
+	float3x3 tangentSpaceAxis = float3x3(input.Tangent.xyz, biNormal, input.Normal);
 	float3 newNormal = normalize(mul(normalMapSample.xyz, tangentSpaceAxis));
 
 	//Specular + Glossiness
@@ -343,4 +375,97 @@ technique11 LambertPhongImprovedTechnique
 		SetGeometryShader( NULL );
 		SetPixelShader( CompileShader( ps_5_0, PSLP2anisotropic() ) );
 	}
+}
+
+technique11 LambertPhongImprovedPackedTechnique
+{
+	pass PpointB
+	{
+		SetRasterizerState(gRasterizerStateBackCulling);
+		SetDepthStencilState(gDepthStencilState, 0);
+		SetBlendState(gBlendState, float4(0.0f, 0.0f, 0.0f, 0.0f), 0xFFFFFFFF);
+		SetVertexShader( CompileShader( vs_5_0, VSPacked() ) );
+		SetGeometryShader( NULL );
+		SetPixelShader( CompileShader( ps_5_0, PSLP2point() ) );
+	}
+	
+	pass PpointF
+	{
+		SetRasterizerState(gRasterizerStateFrontCulling);
+		SetDepthStencilState(gDepthStencilState, 0);
+		SetBlendState(gBlendState, float4(0.0f, 0.0f, 0.0f, 0.0f), 0xFFFFFFFF);
+		SetVertexShader( CompileShader( vs_5_0, VSPacked() ) );
+		SetGeometryShader( NULL );
+		SetPixelShader( CompileShader( ps_5_0, PSLP2point() ) );
+	}
+	
+	pass PpointN
+	{
+		SetRasterizerState(gRasterizerStateNoCulling);
+		SetDepthStencilState(gDepthStencilState, 0);
+		SetBlendState(gBlendState, float4(0.0f, 0.0f, 0.0f, 0.0f), 0xFFFFFFFF);
+		SetVertexShader( CompileShader( vs_5_0, VSPacked() ) );
+		SetGeometryShader( NULL );
+		SetPixelShader( CompileShader( ps_5_0, PSLP2point() ) );
+	}
+	
+	pass PlinearB
+	{
+		SetRasterizerState(gRasterizerStateBackCulling);
+		SetDepthStencilState(gDepthStencilState, 0);
+		SetBlendState(gBlendState, float4(0.0f, 0.0f, 0.0f, 0.0f), 0xFFFFFFFF);
+		SetVertexShader( CompileShader( vs_5_0, VSPacked() ) );
+		SetGeometryShader( NULL );
+		SetPixelShader( CompileShader( ps_5_0, PSLP2linear() ) );
+	}
+	
+	pass PlinearF
+	{
+		SetRasterizerState(gRasterizerStateFrontCulling);
+		SetDepthStencilState(gDepthStencilState, 0);
+		SetBlendState(gBlendState, float4(0.0f, 0.0f, 0.0f, 0.0f), 0xFFFFFFFF);
+		SetVertexShader( CompileShader( vs_5_0, VSPacked() ) );
+		SetGeometryShader( NULL );
+		SetPixelShader( CompileShader( ps_5_0, PSLP2linear() ) );
+	}
+	
+	pass PlinearN
+	{
+		SetRasterizerState(gRasterizerStateNoCulling);
+		SetDepthStencilState(gDepthStencilState, 0);
+		SetBlendState(gBlendState, float4(0.0f, 0.0f, 0.0f, 0.0f), 0xFFFFFFFF);
+		SetVertexShader( CompileShader( vs_5_0, VSPacked() ) );
+		SetGeometryShader( NULL );
+		SetPixelShader( CompileShader( ps_5_0, PSLP2linear() ) );
+	}
+	
+	pass PanisotropicB
+	{
+		SetRasterizerState(gRasterizerStateBackCulling);
+		SetDepthStencilState(gDepthStencilState, 0);
+		SetBlendState(gBlendState, float4(0.0f, 0.0f, 0.0f, 0.0f), 0xFFFFFFFF);
+		SetVertexShader( CompileShader( vs_5_0, VSPacked() ) );
+		SetGeometryShader( NULL );
+		SetPixelShader( CompileShader( ps_5_0, PSLP2anisotropic() ) );
+	}
+	
+	pass PanisotropicF
+	{
+		SetRasterizerState(gRasterizerStateFrontCulling);
+		SetDepthStencilState(gDepthStencilState, 0);
+		SetBlendState(gBlendState, float4(0.0f, 0.0f, 0.0f, 0.0f), 0xFFFFFFFF);
+		SetVertexShader( CompileShader( vs_5_0, VSPacked() ) );
+		SetGeometryShader( NULL );
+		SetPixelShader( CompileShader( ps_5_0, PSLP2anisotropic() ) );
+	}
+	
+	pass PanisotropicN
+	{
+		SetRasterizerState(gRasterizerStateNoCulling);
+		SetDepthStencilState(gDepthStencilState, 0);
+		SetBlendState(gBlendState, float4(0.0f, 0.0f, 0.0f, 0.0f), 0xFFFFFFFF);
+		SetVertexShader( CompileShader( vs_5_0, VSPacked() ) );
+		SetGeometryShader( NULL );
+		SetPixelShader( CompileShader( ps_5_0, PSLP2anisotropic() ) );
+	}
 }
\ No newline at end of file
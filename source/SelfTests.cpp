@@ -0,0 +1,320 @@
+#include "pch.h"
+
+#include <iostream>
+
+#include "SelfTests.h"
+#include "Triangle.h"
+#include "RasterKernels.h"
+#include "Texture.h"
+
+//=== Helpers ===//
+namespace
+{
+	bool Check(bool isPassed, const std::string& name)
+	{
+		if (!isPassed)
+		{
+			std::cout << "FAILED: " << name << std::endl;
+		}
+		return isPassed;
+	}
+
+	//Signed distance of p to the line a -> b, > 0 when p is left of it
+	float EdgeDistance(const Elite::FPoint2& a, const Elite::FPoint2& b, const Elite::FPoint2& p)
+	{
+		return ((b.x - a.x) * (p.y - a.y) - (b.y - a.y) * (p.x - a.x)) / std::sqrt((b.x - a.x) * (b.x - a.x) + (b.y - a.y) * (b.y - a.y));
+	}
+
+	//What one span kernel produced for a fanned polygon: how often every pixel is covered,
+	//and per span call (in walking order) the returned mask, the depth it wrote and the batch of the covered pixels
+	struct KernelOutput
+	{
+		std::vector<uint32_t> coverage;
+		std::vector<uint32_t> masks;
+		std::vector<float> depths;
+		std::vector<float> weights;
+	};
+
+	//Fans a convex polygon into triangles (around its center when there is one, else from the first corner) and rasterizes them on a
+	//size x size screen with the span kernel, walked like Renderer::RasterizationStage: spans of one block row, edges evaluated at the
+	//center of the top left pixel of a block and only stepped from there, every triangle gets its own cleared depth buffer
+	KernelOutput RasterizeCoverage(const std::vector<Elite::FPoint2>& outline, const Elite::FPoint2* pCenter, uint32_t size, Elite::RasterKernel kernel)
+	{
+		//Depth differs per corner so the kernels really interpolate it
+		VertexStreams streams{};
+		for (size_t i{}; i < outline.size(); ++i)
+		{
+			streams.screenPositions.push_back(Elite::FPoint4{ outline[i].x, outline[i].y, 0.3f + 0.05f * i, 1.f + 0.5f * i });
+		}
+		if (pCenter)
+		{
+			streams.screenPositions.push_back(Elite::FPoint4{ pCenter->x, pCenter->y, 0.2f, 2.f });
+		}
+		streams.Resize(streams.screenPositions.size(), false);
+
+		const Elite::SpanKernel rasterizeSpan{ Elite::GetSpanKernel(kernel) };
+		const uint32_t blockSize{ PixelBatch::size };
+		const uint32_t amountCorners{ uint32_t(outline.size()) };
+		KernelOutput output{};
+		output.coverage.resize(size_t(size) * size);
+		std::vector<float> depthBuffer(size_t(size) * size);
+		const uint32_t amountTriangles{ pCenter ? amountCorners : amountCorners - 2 };
+		for (uint32_t i{}; i < amountTriangles; ++i)
+		{
+			const uint32_t index0{ pCenter ? amountCorners : 0 };
+			const uint32_t index1{ pCenter ? i : i + 1 };
+			const uint32_t index2{ pCenter ? (i + 1) % amountCorners : i + 2 };
+			Triangle triangle{ streams, index0, index1, index2 };
+
+			TriangleSetup setup{};
+			setup.pTriangle = &triangle;
+			if (!triangle.Setup(setup, Triangle::CullMode::NoCulling, size, size))
+			{
+				continue;
+			}
+
+			std::fill(depthBuffer.begin(), depthBuffer.end(), FLT_MAX);
+			PixelBatch batch{};
+			for (uint32_t blockY{ setup.minY / blockSize * blockSize }; blockY < setup.maxY; blockY += blockSize)
+			{
+				for (uint32_t blockX{ setup.minX / blockSize * blockSize }; blockX < setup.maxX; blockX += blockSize)
+				{
+					const uint32_t spanMinX{ std::max(blockX, setup.minX) };
+					const uint32_t spanMaxX{ std::min(blockX + blockSize, setup.maxX) };
+					const uint32_t rowMinY{ std::max(blockY, setup.minY) };
+					const uint32_t rowMaxY{ std::min(blockY + blockSize, setup.maxY) };
+
+					const int32_t centerX{ int32_t(spanMinX) * EdgeFunction::subPixelScale + EdgeFunction::subPixelScale / 2 };
+					const int32_t centerY{ int32_t(rowMinY) * EdgeFunction::subPixelScale + EdgeFunction::subPixelScale / 2 };
+					int32_t rowEdges[3]{ int32_t(setup.edges[0].Evaluate(centerX, centerY)), int32_t(setup.edges[1].Evaluate(centerX, centerY)),
+						int32_t(setup.edges[2].Evaluate(centerX, centerY)) };
+
+					for (uint32_t r{ rowMinY }; r < rowMaxY; ++r)
+					{
+						float* pDepth{ depthBuffer.data() + spanMinX + size_t(r) * size };
+						const uint32_t count{ spanMaxX - spanMinX };
+						uint32_t mask{ rasterizeSpan(setup, rowEdges, count, pDepth, batch) };
+						output.masks.push_back(mask);
+						output.depths.insert(output.depths.end(), pDepth, pDepth + count);
+
+						while (mask)
+						{
+							const uint32_t j{ Elite::LowestBitIndex(mask) };
+							mask &= mask - 1;
+
+							++output.coverage[spanMinX + j + size_t(r) * size];
+							output.weights.insert(output.weights.end(), { batch.weight0[j], batch.weight1[j], batch.weight2[j], batch.wInterpolated[j] });
+						}
+
+						rowEdges[0] += setup.edges[0].b * EdgeFunction::subPixelScale;
+						rowEdges[1] += setup.edges[1].b * EdgeFunction::subPixelScale;
+						rowEdges[2] += setup.edges[2].b * EdgeFunction::subPixelScale;
+					}
+				}
+			}
+		}
+
+		return output;
+	}
+
+	//Triangles sharing edges (and vertices) may never both cover a pixel, and pixels inside the polygon have to be covered exactly once,
+	//for every span kernel this CPU runs, and the SIMD kernels have to return the same masks, depth and weights as the scalar one
+	bool CheckSharedEdges(const std::string& name, const std::vector<Elite::FPoint2>& outline, const Elite::FPoint2* pCenter)
+	{
+		const uint32_t size{ 32 };
+		const KernelOutput reference{ RasterizeCoverage(outline, pCenter, size, Elite::RasterKernel::Scalar) };
+
+		bool isPassed{ true };
+		for (uint32_t k{}; k < uint32_t(Elite::RasterKernel::Count); ++k)
+		{
+			const Elite::RasterKernel kernel{ Elite::RasterKernel(k) };
+			if (!Elite::IsRasterKernelSupported(kernel))
+			{
+				continue;
+			}
+
+			const std::string kernelName{ name + " (" + Elite::GetRasterKernelName(kernel) + ")" };
+			const KernelOutput output{ (kernel == Elite::RasterKernel::Scalar) ? reference : RasterizeCoverage(outline, pCenter, size, kernel) };
+			isPassed &= Check(output.masks == reference.masks, kernelName + ": span masks differ from the scalar kernel");
+			isPassed &= Check(output.depths == reference.depths, kernelName + ": depth differs from the scalar kernel");
+			isPassed &= Check(output.weights == reference.weights, kernelName + ": weights differ from the scalar kernel");
+
+			for (uint32_t r{}; r < size; ++r)
+			{
+				for (uint32_t c{}; c < size; ++c)
+				{
+					const uint32_t amountCovered{ output.coverage[c + size_t(r) * size] };
+					isPassed &= Check(amountCovered <= 1, kernelName + ": pixel (" + std::to_string(c) + ", " + std::to_string(r) + ") covered twice");
+
+					//Counter clockwise outlines (y down), pixels on or right next to the outline (snapping moves it) belong to the neighbours of the polygon
+					const Elite::FPoint2 center{ c + 0.5f, r + 0.5f };
+					bool isInside{ true };
+					for (size_t i{}; i < outline.size(); ++i)
+					{
+						isInside &= EdgeDistance(outline[i], outline[(i + 1) % outline.size()], center) < -0.1f;
+					}
+					if (isInside)
+					{
+						isPassed &= Check(amountCovered == 1, kernelName + ": pixel (" + std::to_string(c) + ", " + std::to_string(r) + ") not covered");
+					}
+				}
+			}
+		}
+		return isPassed;
+	}
+
+	bool TestTopLeftFillRule()
+	{
+		bool isPassed{ true };
+
+		//Quad split along its diagonal, every edge runs exactly through pixel centers (the case the fill rule decides)
+		const std::vector<Elite::FPoint2> centerQuad{ { 2.5f, 2.5f }, { 2.5f, 20.5f }, { 20.5f, 20.5f }, { 20.5f, 2.5f } };
+		isPassed &= CheckSharedEdges("quad on pixel centers", centerQuad, nullptr);
+
+		//Same quad with corners off the pixel grid, shared edge snapped to 28.4
+		const std::vector<Elite::FPoint2> skewedQuad{ { 1.3f, 1.7f }, { 3.1f, 27.05f }, { 26.4f, 24.6f }, { 23.9f, 2.2f } };
+		isPassed &= CheckSharedEdges("quad off the pixel grid", skewedQuad, nullptr);
+
+		//Fan around a center on a pixel center, every triangle shares two edges and all of them share one vertex
+		const Elite::FPoint2 fanCenter{ 15.5f, 15.5f };
+		const std::vector<Elite::FPoint2> fanOutline{ { 15.5f, 1.5f }, { 5.5f, 5.5f }, { 1.5f, 15.5f }, { 5.5f, 25.5f },
+			{ 15.5f, 29.5f }, { 25.5f, 25.5f }, { 29.5f, 15.5f }, { 25.5f, 5.5f } };
+		isPassed &= CheckSharedEdges("fan around a pixel center", fanOutline, &fanCenter);
+
+		return isPassed;
+	}
+
+	//=== Block compression ===//
+	//Two 565 endpoints and 2 bit indices (texel 0 in the lowest bits)
+	void MakeColorBlock(uint16_t color0, uint16_t color1, const uint8_t indices[16], uint8_t* pBlock)
+	{
+		uint32_t bits{};
+		for (uint32_t i{}; i < 16; ++i)
+		{
+			bits |= uint32_t(indices[i]) << (2 * i);
+		}
+		const uint8_t block[8]{ uint8_t(color0), uint8_t(color0 >> 8), uint8_t(color1), uint8_t(color1 >> 8),
+			uint8_t(bits), uint8_t(bits >> 8), uint8_t(bits >> 16), uint8_t(bits >> 24) };
+		std::copy_n(block, 8, pBlock);
+	}
+
+	//Two 8 bit endpoints and 3 bit indices (texel 0 in the lowest bits)
+	void MakeScalarBlock(uint8_t value0, uint8_t value1, const uint8_t indices[16], uint8_t* pBlock)
+	{
+		uint64_t bits{};
+		for (uint32_t i{}; i < 16; ++i)
+		{
+			bits |= uint64_t(indices[i]) << (3 * i);
+		}
+		pBlock[0] = value0;
+		pBlock[1] = value1;
+		for (uint32_t i{}; i < 6; ++i)
+		{
+			pBlock[2 + i] = uint8_t(bits >> (8 * i));
+		}
+	}
+
+	bool CheckBlock(const std::string& name, Texture::TexelFormat format, const uint8_t* pBlock, const uint32_t expected[16])
+	{
+		uint32_t texels[16];
+		Texture::DecodeBlock(format, pBlock, texels);
+
+		bool isPassed{ true };
+		for (uint32_t i{}; i < 16; ++i)
+		{
+			isPassed &= Check(texels[i] == expected[i], name + ": texel " + std::to_string(i) + " is " + std::to_string(texels[i]) + ", expected " + std::to_string(expected[i]));
+		}
+		return isPassed;
+	}
+
+	//Endpoints are picked so every interpolated value is exact, RGBA8 texels have red in the lowest byte
+	bool TestBlockDecoding()
+	{
+		bool isPassed{ true };
+		const uint8_t colorIndices[16]{ 0, 1, 2, 3, 0, 1, 2, 3, 0, 1, 2, 3, 0, 1, 2, 3 };
+		const uint8_t scalarIndices[16]{ 0, 1, 2, 3, 4, 5, 6, 7, 0, 1, 2, 3, 4, 5, 6, 7 };
+		const uint8_t reversedIndices[16]{ 7, 6, 5, 4, 3, 2, 1, 0, 7, 6, 5, 4, 3, 2, 1, 0 };
+		const uint8_t ramp8[8]{ 210, 140, 200, 190, 180, 170, 160, 150 }; //210 > 140 -> 6 interpolated values
+		const uint8_t ramp6[8]{ 100, 200, 120, 140, 160, 180, 0, 255 }; //100 <= 200 -> 4 interpolated values, then 0 and 255
+
+		//BC1, color0 > color1 -> 4 colors (pure red 0xF800 and pure blue 0x001F, thirds are exact)
+		uint8_t bc1[8];
+		MakeColorBlock(0xF800, 0x001F, colorIndices, bc1);
+		const uint32_t palette4[4]{ 0xFF0000FF, 0xFFFF0000, 0xFF5500AA, 0xFFAA0055 };
+		uint32_t expected[16];
+		for (uint32_t i{}; i < 16; ++i)
+		{
+			expected[i] = palette4[colorIndices[i]];
+		}
+		isPassed &= CheckBlock("BC1 4 colors", Texture::TexelFormat::BC1, bc1, expected);
+
+		//BC1, color0 <= color1 -> 3 colors and transparent black (punch-through), red 16 of 31 expands to 132
+		MakeColorBlock(0x0000, 0x8000, colorIndices, bc1);
+		const uint32_t palette3[4]{ 0xFF000000, 0xFF000084, 0xFF000042, 0x00000000 };
+		for (uint32_t i{}; i < 16; ++i)
+		{
+			expected[i] = palette3[colorIndices[i]];
+		}
+		isPassed &= CheckBlock("BC1 3 colors", Texture::TexelFormat::BC1, bc1, expected);
+
+		//BC3, alpha with 6 and with 4 interpolated values, the color block always uses 4 colors (even when color0 <= color1)
+		uint8_t bc3[16];
+		MakeScalarBlock(210, 140, scalarIndices, bc3);
+		MakeColorBlock(0x0000, 0x8000, colorIndices, bc3 + 8);
+		const uint32_t colors[4]{ 0x000000, 0x000084, 0x00002C, 0x000058 };
+		for (uint32_t i{}; i < 16; ++i)
+		{
+			expected[i] = colors[colorIndices[i]] | (uint32_t(ramp8[scalarIndices[i]]) << 24);
+		}
+		isPassed &= CheckBlock("BC3 8 alpha values", Texture::TexelFormat::BC3, bc3, expected);
+
+		MakeScalarBlock(100, 200, scalarIndices, bc3);
+		for (uint32_t i{}; i < 16; ++i)
+		{
+			expected[i] = colors[colorIndices[i]] | (uint32_t(ramp6[scalarIndices[i]]) << 24);
+		}
+		isPassed &= CheckBlock("BC3 6 alpha values", Texture::TexelFormat::BC3, bc3, expected);
+
+		//BC5, red and green from one block each (one of both ramps), blue zero and opaque
+		uint8_t bc5[16];
+		MakeScalarBlock(210, 140, scalarIndices, bc5);
+		MakeScalarBlock(100, 200, reversedIndices, bc5 + 8);
+		for (uint32_t i{}; i < 16; ++i)
+		{
+			expected[i] = uint32_t(ramp8[scalarIndices[i]]) | (uint32_t(ramp6[reversedIndices[i]]) << 8) | 0xFF000000;
+		}
+		isPassed &= CheckBlock("BC5", Texture::TexelFormat::BC5, bc5, expected);
+
+		return isPassed;
+	}
+
+	//=== Texture footprint ===//
+	//Derivatives of pixels far outside a triangle can overflow, the footprint still has to stay within the tap and mip limits
+	bool TestDegenerateFootprint()
+	{
+		bool isPassed{ true };
+		const float infinity{ std::numeric_limits<float>::infinity() };
+		const Elite::FVector2 derivatives[][2]{ { { infinity, 0.f }, { 0.f, 0.01f } }, { { infinity, 0.f }, { 0.f, infinity } },
+			{ { 1e30f, 0.f }, { 0.f, 1e-30f } }, { { 0.5f, 0.f }, { 0.f, 0.f } } };
+		for (const Elite::FVector2* pDerivatives : derivatives)
+		{
+			const Texture::Footprint footprint{ Texture::ComputeFootprint(256, 256, 9, pDerivatives[0], pDerivatives[1], Mesh::Filter::Anisotropic) };
+			const std::string name{ "footprint of (" + std::to_string(pDerivatives[0].x) + ", " + std::to_string(pDerivatives[1].y) + ")" };
+			isPassed &= Check(footprint.amountTaps >= 1 && footprint.amountTaps <= Texture::maxAnisotropy, name + ": " + std::to_string(footprint.amountTaps) + " taps");
+			isPassed &= Check(footprint.lod >= 0.f && footprint.lod <= 8.f, name + ": lod " + std::to_string(footprint.lod));
+		}
+		return isPassed;
+	}
+}
+
+//=== Functions ===//
+bool Elite::RunSelfTests()
+{
+	bool isPassed{ true };
+	isPassed &= Check(TestTopLeftFillRule(), "top-left fill rule");
+	isPassed &= Check(TestBlockDecoding(), "block compressed decoding");
+	isPassed &= Check(TestDegenerateFootprint(), "degenerate texture footprint");
+
+	std::cout << (isPassed ? "All self tests passed" : "Self tests failed") << std::endl;
+	return isPassed;
+}
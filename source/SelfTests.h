@@ -0,0 +1,9 @@
+#pragma once
+
+namespace Elite
+{
+	//=== Functions ===//
+	//Deterministic checks of the software pipeline that don't need a window or a device (main.exe --selftest)
+	//Prints every failed check, returns true when all of them passed
+	bool RunSelfTests();
+}
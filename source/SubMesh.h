@@ -0,0 +1,13 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+//=== SubMesh struct ===//
+//Triangles of one material, a contiguous range of the index buffer
+struct SubMesh
+{
+	std::string material; //usemtl name, empty for faces before any usemtl
+	uint32_t firstIndex;
+	uint32_t amountIndices;
+};
@@ -0,0 +1,132 @@
+#include "pch.h"
+
+#include <cmath>
+#include <functional>
+
+#include "Tangents.h"
+#include "ThreadPool.h"
+
+//=== Helpers ===//
+namespace
+{
+	struct TangentSum
+	{
+		Elite::FVector3 tangent;
+		Elite::FVector3 bitangent;
+	};
+
+	//Ranges are only worth the scheduling above this many triangles
+	const size_t g_MinTrianglesPerRange{ 16 * 1024 };
+
+	//UV gradient of one triangle, zero when it has no UV area (it would only add NaNs)
+	TangentSum ComputeGradient(const Vertex* pVertices, uint32_t index0, uint32_t index1, uint32_t index2)
+	{
+		const Elite::FPoint4& p0{ pVertices[index0].position };
+		const Elite::FPoint4& p1{ pVertices[index1].position };
+		const Elite::FPoint4& p2{ pVertices[index2].position };
+		const Elite::FVector2& uv0{ pVertices[index0].uv };
+		const Elite::FVector2& uv1{ pVertices[index1].uv };
+		const Elite::FVector2& uv2{ pVertices[index2].uv };
+
+		const Elite::FVector3 edge0{ p1 - p0 };
+		const Elite::FVector3 edge1{ p2 - p0 };
+		const Elite::FVector2 diffX{ uv1.x - uv0.x, uv2.x - uv0.x };
+		const Elite::FVector2 diffY{ uv1.y - uv0.y, uv2.y - uv0.y };
+
+		const float r{ 1.f / Cross(diffX, diffY) };
+		if (!std::isfinite(r))
+		{
+			return TangentSum{};
+		}
+
+		return TangentSum{ (edge0 * diffY.y - edge1 * diffY.x) * r, (edge1 * diffX.x - edge0 * diffX.y) * r };
+	}
+
+	void ResolveVertex(Vertex& vertex, const TangentSum& sum)
+	{
+		const Elite::FVector3& normal{ vertex.normal };
+		const bool hasNormal{ Elite::SqrMagnitude(normal) > 0.f };
+
+		Elite::FVector3 tangent{ hasNormal ? Elite::Reject(sum.tangent, normal) : sum.tangent };
+		if (!(Elite::SqrMagnitude(tangent) > 1e-20f))
+		{
+			//Degenerate (no usable triangle or tangent parallel to the normal), any perpendicular axis will do
+			tangent = hasNormal ? Elite::Reject(Elite::FVector3{ 1.f, 0.f, 0.f }, normal) : Elite::FVector3{ 1.f, 0.f, 0.f };
+			if (!(Elite::SqrMagnitude(tangent) > 1e-20f))
+			{
+				tangent = Elite::Reject(Elite::FVector3{ 0.f, 1.f, 0.f }, normal);
+			}
+		}
+
+		vertex.tangent = Elite::GetNormalized(tangent);
+		vertex.tangentSign = (Elite::Dot(Elite::Cross(vertex.tangent, normal), sum.bitangent) < 0.f) ? -1.f : 1.f;
+	}
+}
+
+//=== Functions ===//
+void Elite::GenerateTangents(Vertex* pVertices, size_t amountVertices, const uint32_t* pIndices, size_t amountIndices, ThreadPool* pThreadPool)
+{
+	//Runs on the pool when there is one
+	const auto parallelFor = [pThreadPool](uint32_t amountJobs, const std::function<void(uint32_t)>& job)
+	{
+		if (pThreadPool)
+		{
+			pThreadPool->ParallelFor(amountJobs, job);
+			return;
+		}
+		for (uint32_t i{}; i < amountJobs; ++i)
+		{
+			job(i);
+		}
+	};
+
+	//Gradients per triangle in parallel, they only read the vertices
+	const size_t amountTriangles{ amountIndices / 3 };
+	const size_t amountThreads{ pThreadPool ? pThreadPool->GetAmountThreads() : 1 };
+	const uint32_t amountRanges{ uint32_t(std::max(std::min(amountThreads, amountTriangles / g_MinTrianglesPerRange), size_t(1))) };
+
+	std::vector<TangentSum> gradients(amountTriangles);
+	parallelFor(amountRanges, [&](uint32_t range)
+		{
+			const size_t end{ amountTriangles * (range + 1) / amountRanges };
+			for (size_t triangle{ amountTriangles * range / amountRanges }; triangle < end; ++triangle)
+			{
+				gradients[triangle] = ComputeGradient(pVertices, pIndices[triangle * 3], pIndices[triangle * 3 + 1], pIndices[triangle * 3 + 2]);
+			}
+		});
+
+	//Vertex -> triangle adjacency (count the corners per vertex, prefix sum into offsets, fill in corner order), built once
+	//Memory is one offset per vertex and one entry per corner whatever the amount of threads
+	std::vector<uint32_t> offsets(amountVertices + 1);
+	for (size_t i{}; i < amountTriangles * 3; ++i)
+	{
+		++offsets[pIndices[i] + 1];
+	}
+	for (size_t index{}; index < amountVertices; ++index)
+	{
+		offsets[index + 1] += offsets[index];
+	}
+	std::vector<uint32_t> adjacentTriangles(amountTriangles * 3);
+	std::vector<uint32_t> fillPositions(offsets.begin(), offsets.end() - 1);
+	for (size_t i{}; i < amountTriangles * 3; ++i)
+	{
+		adjacentTriangles[fillPositions[pIndices[i]]++] = uint32_t(i / 3);
+	}
+
+	//Every range of vertices sums the gradients of its own triangles and orthogonalizes, no vertex is written by two ranges
+	//and the sums are added in corner order, so the result doesn't depend on the split
+	parallelFor(amountRanges, [&](uint32_t job)
+		{
+			const size_t end{ amountVertices * (job + 1) / amountRanges };
+			for (size_t index{ amountVertices * job / amountRanges }; index < end; ++index)
+			{
+				TangentSum sum{};
+				for (uint32_t i{ offsets[index] }; i < offsets[index + 1]; ++i)
+				{
+					sum.tangent += gradients[adjacentTriangles[i]].tangent;
+					sum.bitangent += gradients[adjacentTriangles[i]].bitangent;
+				}
+				ResolveVertex(pVertices[index], sum);
+			}
+		});
+}
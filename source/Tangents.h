@@ -0,0 +1,14 @@
+#pragma once
+
+#include "Vertex.h"
+
+class ThreadPool;
+
+namespace Elite
+{
+	//=== Functions ===//
+	//Per vertex tangent from the UV gradients of the triangles around it, orthogonalized against the normal,
+	//tangentSign stores the handedness (bitangent = Cross(tangent, normal) * tangentSign) so mirrored UVs shade correctly
+	//Triangles without UV area are skipped, a vertex without any usable triangle gets an arbitrary tangent perpendicular to its normal
+	void GenerateTangents(Vertex* pVertices, size_t amountVertices, const uint32_t* pIndices, size_t amountIndices, ThreadPool* pThreadPool = nullptr);
+}
@@ -1,32 +1,320 @@
 #include "pch.h"
 
 #include <iostream>
+#include <cmath>
+#include <cstring>
+#include <emmintrin.h>
 
 #include "SDL_image.h"
 
 #include "Texture.h"
+#include "CookedFile.h"
+
+//=== Helpers ===//
+namespace
+{
+	//Byte -> [0, 1] float, replaces the three divides by 255 per texel
+	struct ByteToFloatTable
+	{
+		ByteToFloatTable()
+		{
+			for (int i{}; i < 256; ++i)
+			{
+				values[i] = float(i) / 255.f;
+			}
+		}
+
+		float values[256];
+	};
+
+	const ByteToFloatTable g_ByteToFloat{};
+
+	//RGBA8 texel -> 4 floats in [0, 255], one channel per lane
+	inline __m128 UnpackTexel(uint32_t texel)
+	{
+		const __m128i zero{ _mm_setzero_si128() };
+		const __m128i bytes{ _mm_cvtsi32_si128(int(texel)) };
+		return _mm_cvtepi32_ps(_mm_unpacklo_epi16(_mm_unpacklo_epi8(bytes, zero), zero));
+	}
+
+	//8 byte material texel -> two times 4 floats in [0, 255]
+	inline void UnpackTexel(const uint8_t* pTexel, __m128& low, __m128& high)
+	{
+		const __m128i zero{ _mm_setzero_si128() };
+		const __m128i words{ _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(pTexel)), zero) };
+		low = _mm_cvtepi32_ps(_mm_unpacklo_epi16(words, zero));
+		high = _mm_cvtepi32_ps(_mm_unpackhi_epi16(words, zero));
+	}
+
+	//Bilinear blend of four unpacked texels, scaled to [0, 1]
+	inline __m128 BlendTexels(__m128 c00, __m128 c10, __m128 c01, __m128 c11, __m128 weightX, __m128 weightY)
+	{
+		const __m128 top{ _mm_add_ps(c00, _mm_mul_ps(_mm_sub_ps(c10, c00), weightX)) };
+		const __m128 bottom{ _mm_add_ps(c01, _mm_mul_ps(_mm_sub_ps(c11, c01), weightX)) };
+		return _mm_mul_ps(_mm_add_ps(top, _mm_mul_ps(_mm_sub_ps(bottom, top), weightY)), _mm_set1_ps(1.f / 255.f));
+	}
+
+	//=== DDS ===//
+	uint32_t ReadUInt32(const uint8_t* pData, size_t offset)
+	{
+		uint32_t value{};
+		std::memcpy(&value, pData + offset, sizeof(value));
+		return value;
+	}
+
+	const uint32_t g_DDSMagic{ MakeFourCC('D', 'D', 'S', ' ') };
+	const size_t g_DDSHeaderSize{ 128 }; //Magic + DDS_HEADER
+	const size_t g_DDSHeaderDX10Size{ 20 };
+
+	//=== Cooked ===//
+	//Header, source path, mip table, then the RGBA8 texels of every level (row-major, cache line aligned)
+	struct CookedTextureHeader
+	{
+		CookedHeader cooked;
+		uint32_t amountMipLevels;
+	};
+	struct CookedMipLevel
+	{
+		uint32_t width;
+		uint32_t height;
+		uint64_t offset;
+	};
+
+	const uint32_t g_CookedMagic{ MakeFourCC('T', 'X', 'C', 'K') };
+	const uint32_t g_CookedVersion{ 2 };
+
+	//=== BlockCache ===//
+	//Recently decoded 4x4 blocks, direct mapped on the block address (16KB of texels, stays in L1)
+	//Per thread so tiles never share it, blocks are only freed together with their texture at shutdown
+	struct BlockCache
+	{
+		static const uint32_t amountEntries{ 256 };
+
+		const uint8_t* pBlocks[amountEntries]{};
+		uint32_t texels[amountEntries][16];
+	};
+
+	thread_local BlockCache g_BlockCache;
+
+	//=== BCn ===//
+	//565 -> 888, replicating the high bits into the low ones like the hardware does
+	uint32_t Expand565(uint16_t color)
+	{
+		const uint32_t r{ uint32_t(color >> 11) & 0x1F }, g{ uint32_t(color >> 5) & 0x3F }, b{ uint32_t(color) & 0x1F };
+		return ((r << 3) | (r >> 2)) | (((g << 2) | (g >> 4)) << 8) | (((b << 3) | (b >> 2)) << 16);
+	}
+
+	uint32_t Blend888(uint32_t color0, uint32_t color1, uint32_t weight0, uint32_t weight1, uint32_t divisor)
+	{
+		uint32_t result{};
+		for (uint32_t shift{}; shift < 24; shift += 8)
+		{
+			result |= ((((color0 >> shift) & 0xFF) * weight0 + ((color1 >> shift) & 0xFF) * weight1) / divisor) << shift;
+		}
+		return result;
+	}
+
+	//BC1 color block, 2 bits per texel into a 4 entry palette, alpha is written as opaque
+	void DecodeColorBlock(const uint8_t* pBlock, bool allowTransparent, uint32_t texels[16])
+	{
+		const uint16_t color0{ uint16_t(pBlock[0] | (pBlock[1] << 8)) };
+		const uint16_t color1{ uint16_t(pBlock[2] | (pBlock[3] << 8)) };
+
+		const uint32_t opaque{ 0xFF000000 };
+		uint32_t palette[4]{ Expand565(color0) | opaque, Expand565(color1) | opaque };
+		if (color0 > color1 || !allowTransparent)
+		{
+			palette[2] = Blend888(palette[0], palette[1], 2, 1, 3) | opaque;
+			palette[3] = Blend888(palette[0], palette[1], 1, 2, 3) | opaque;
+		}
+		else
+		{
+			palette[2] = Blend888(palette[0], palette[1], 1, 1, 2) | opaque;
+			palette[3] = 0; //Transparent black
+		}
+
+		const uint32_t indices{ uint32_t(pBlock[4]) | (uint32_t(pBlock[5]) << 8) | (uint32_t(pBlock[6]) << 16) | (uint32_t(pBlock[7]) << 24) };
+		for (uint32_t i{}; i < 16; ++i)
+		{
+			texels[i] = palette[(indices >> (2 * i)) & 0x3];
+		}
+	}
+
+	//BC3 alpha / BC4 block, 3 bits per texel into an 8 entry ramp between two endpoints
+	void DecodeScalarBlock(const uint8_t* pBlock, uint8_t values[16])
+	{
+		const uint32_t value0{ pBlock[0] }, value1{ pBlock[1] };
+
+		uint8_t ramp[8]{ uint8_t(value0), uint8_t(value1) };
+		if (value0 > value1)
+		{
+			for (uint32_t i{ 1 }; i < 7; ++i)
+			{
+				ramp[i + 1] = uint8_t(((7 - i) * value0 + i * value1) / 7);
+			}
+		}
+		else
+		{
+			for (uint32_t i{ 1 }; i < 5; ++i)
+			{
+				ramp[i + 1] = uint8_t(((5 - i) * value0 + i * value1) / 5);
+			}
+			ramp[6] = 0;
+			ramp[7] = 255;
+		}
+
+		uint64_t indices{};
+		for (uint32_t i{}; i < 6; ++i)
+		{
+			indices |= uint64_t(pBlock[2 + i]) << (8 * i);
+		}
+		for (uint32_t i{}; i < 16; ++i)
+		{
+			values[i] = ramp[(indices >> (3 * i)) & 0x7];
+		}
+	}
+}
 
 //=== Constructors ===//
 Texture::Texture(std::string filePath)
-	: m_pSurface{ nullptr }
+	: m_MipLevels{}
+	, m_BlockLevels{}
+	, m_MaterialLevels{}
+	, m_Format{ TexelFormat::RGBA8 }
+	, m_Layout{ TexelLayout::RowMajor }
 	, m_pTexture{ nullptr }
 	, m_pResourceView{ nullptr }
 {
+	//Block compressed, stays compressed
+	const size_t extension{ filePath.find_last_of('.') };
+	if (extension != std::string::npos && (filePath.compare(extension, 4, ".dds") == 0 || filePath.compare(extension, 4, ".DDS") == 0))
+	{
+		if (!LoadDDS(filePath))
+		{
+			std::cout << "Texture not loaded properly." << std::endl;
+		}
+		return;
+	}
+
+	//Warm start, texels come straight out of the cooked file
+	if (LoadCooked(filePath))
+	{
+		return;
+	}
+
 	//Initializing for all textures
-	m_pSurface = IMG_Load(filePath.c_str());
-	if (!m_pSurface) std::cout << "Texture not loaded properly." << std::endl;
+	SDL_Surface* pSurface = IMG_Load(filePath.c_str());
+	if (!pSurface)
+	{
+		std::cout << "Texture not loaded properly." << std::endl;
+		return;
+	}
+
+	//The surface is only needed to build the mip chain
+	GenerateMips(pSurface);
+	SDL_FreeSurface(pSurface);
+	SaveCooked(filePath);
 }
 
 Texture::Texture(const char* filepath, ID3D11Device* pDevice)
 	: Texture(filepath)
 {
 	//Extra initializing for DirectX textures
+	CreateHardwareTexture(pDevice);
+}
+
+Texture::Texture(const Texture& diffuse, const Texture* pNormal, const Texture* pSpecular, const Texture* pGloss)
+	: m_MipLevels{}
+	, m_BlockLevels{}
+	, m_MaterialLevels{}
+	, m_Format{ TexelFormat::Material }
+	, m_Layout{ TexelLayout::RowMajor }
+	, m_pTexture{ nullptr }
+	, m_pResourceView{ nullptr }
+{
+	if (diffuse.GetAmountMipLevels() == 0)
+	{
+		return;
+	}
+
+	//Level 0 -> packed once from the full resolution levels of the source maps
+	MipLevelMaterial base{ diffuse.GetWidth(), diffuse.GetHeight(), {} };
+	base.texels.resize(size_t(base.width) * base.height);
+
+	const auto sourceTexel = [&base](const Texture& texture, uint32_t x, uint32_t y)
+	{
+		if (texture.GetWidth() == base.width && texture.GetHeight() == base.height)
+		{
+			return texture.GetTexel(x, y);
+		}
+
+		//Other size, point sample at the center of the diffuse texel
+		const Elite::RGBColor color{ texture.Sample(Elite::FVector2{ (x + 0.5f) / base.width, (y + 0.5f) / base.height }) };
+		return uint32_t(color.r * 255.f + 0.5f) | (uint32_t(color.g * 255.f + 0.5f) << 8) | (uint32_t(color.b * 255.f + 0.5f) << 16);
+	};
+
+	for (uint32_t y{}; y < base.height; ++y)
+	{
+		for (uint32_t x{}; x < base.width; ++x)
+		{
+			const uint32_t diffuseTexel{ diffuse.GetTexel(x, y) };
+			const uint32_t normalTexel{ pNormal ? sourceTexel(*pNormal, x, y) : 0x8080u };
+			const uint32_t specularTexel{ pSpecular ? sourceTexel(*pSpecular, x, y) : 0u };
+			const uint32_t glossTexel{ pGloss ? sourceTexel(*pGloss, x, y) : 0u };
+
+			//Specular and gloss maps are greyscale, red is enough
+			MaterialTexel& texel{ base.texels[x + size_t(y) * base.width] };
+			texel.channels[DiffuseR] = uint8_t(diffuseTexel);
+			texel.channels[DiffuseG] = uint8_t(diffuseTexel >> 8);
+			texel.channels[DiffuseB] = uint8_t(diffuseTexel >> 16);
+			texel.channels[NormalX] = uint8_t(normalTexel);
+			texel.channels[NormalY] = uint8_t(normalTexel >> 8);
+			texel.channels[Specular] = uint8_t(specularTexel);
+			texel.channels[Gloss] = uint8_t(glossTexel);
+			texel.channels[AmountMaterialChannels] = 0;
+		}
+	}
+	base.UseOwnTexels();
+	m_MaterialLevels.push_back(std::move(base));
+
+	GenerateMips(m_MaterialLevels);
+}
+
+//=== Destructor ===//
+Texture::~Texture()
+{
+	if (m_pResourceView)
+	{
+		m_pResourceView->Release();
+	}
+
+	if (m_pTexture)
+	{
+		m_pTexture->Release();
+	}
+}
+
+//=== Functions ===//
+void Texture::CreateHardwareTexture(ID3D11Device* pDevice)
+{
+	//Material textures are software only, the hardware samples the source maps
+	if (GetAmountMipLevels() == 0 || m_pTexture || m_Format == TexelFormat::Material)
+	{
+		return;
+	}
+
 	D3D11_TEXTURE2D_DESC desc{};
-	desc.Width = m_pSurface->w;
-	desc.Height = m_pSurface->h;
-	desc.MipLevels = 1;
+	desc.Width = GetWidth();
+	desc.Height = GetHeight();
+	desc.MipLevels = GetAmountMipLevels();
 	desc.ArraySize = 1;
-	desc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+	switch (m_Format)
+	{
+	case TexelFormat::BC1: desc.Format = DXGI_FORMAT_BC1_UNORM; break;
+	case TexelFormat::BC3: desc.Format = DXGI_FORMAT_BC3_UNORM; break;
+	case TexelFormat::BC5: desc.Format = DXGI_FORMAT_BC5_UNORM; break;
+	default: desc.Format = DXGI_FORMAT_R8G8B8A8_UNORM; break;
+	}
 	desc.SampleDesc.Count = 1;
 	desc.SampleDesc.Quality = 0;
 	desc.Usage = D3D11_USAGE_DEFAULT;
@@ -34,11 +322,22 @@ Texture::Texture(const char* filepath, ID3D11Device* pDevice)
 	desc.CPUAccessFlags = 0;
 	desc.MiscFlags = 0;
 
-	D3D11_SUBRESOURCE_DATA initData;
-	initData.pSysMem = m_pSurface->pixels;
-	initData.SysMemPitch = static_cast<UINT>(m_pSurface->pitch);
-	initData.SysMemSlicePitch = static_cast<UINT>(m_pSurface->h * m_pSurface->pitch);
-	HRESULT result = pDevice->CreateTexture2D(&desc, &initData, &m_pTexture);
+	//Same mip chain as the software sampler, blocks are uploaded without decoding (pitch is one row of blocks)
+	std::vector<D3D11_SUBRESOURCE_DATA> initData(desc.MipLevels);
+	for (size_t i{}; i < m_MipLevels.size(); ++i)
+	{
+		initData[i].pSysMem = m_MipLevels[i].pTexels;
+		initData[i].SysMemPitch = static_cast<UINT>(m_MipLevels[i].width * sizeof(uint32_t));
+		initData[i].SysMemSlicePitch = static_cast<UINT>(m_MipLevels[i].amountTexels * sizeof(uint32_t));
+	}
+	for (size_t i{}; i < m_BlockLevels.size(); ++i)
+	{
+		const uint32_t blockBytes{ (m_Format == TexelFormat::BC1) ? BC1Codec::blockBytes : BC3Codec::blockBytes };
+		initData[i].pSysMem = m_BlockLevels[i].pTexels;
+		initData[i].SysMemPitch = static_cast<UINT>((m_BlockLevels[i].width + 3) / 4 * blockBytes);
+		initData[i].SysMemSlicePitch = static_cast<UINT>(m_BlockLevels[i].amountTexels);
+	}
+	HRESULT result = pDevice->CreateTexture2D(&desc, initData.data(), &m_pTexture);
 	if (FAILED(result))
 	{
 		return;
@@ -47,7 +346,7 @@ Texture::Texture(const char* filepath, ID3D11Device* pDevice)
 	D3D11_SHADER_RESOURCE_VIEW_DESC SRVdesc{};
 	SRVdesc.Format = desc.Format;
 	SRVdesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
-	SRVdesc.Texture2D.MipLevels = 1;
+	SRVdesc.Texture2D.MipLevels = desc.MipLevels;
 	result = pDevice->CreateShaderResourceView(m_pTexture, &SRVdesc, &m_pResourceView);
 	if (FAILED(result))
 	{
@@ -55,39 +354,703 @@ Texture::Texture(const char* filepath, ID3D11Device* pDevice)
 	}
 }
 
-//=== Destructor ===//
-Texture::~Texture()
+void Texture::ReleaseTexels()
 {
-	SDL_FreeSurface(m_pSurface);
+	//Swapped out so the memory is freed, not only cleared
+	std::vector<MipLevelRGBA8>{}.swap(m_MipLevels);
+	std::vector<MipLevelBlocks>{}.swap(m_BlockLevels);
+	std::vector<MipLevelMaterial>{}.swap(m_MaterialLevels);
+	m_MappedFile.Close();
+}
 
-	if (m_pResourceView)
+uint32_t Texture::GetWidth() const
+{
+	switch (m_Format)
 	{
-		m_pResourceView->Release();
+	case TexelFormat::RGBA8: return m_MipLevels.empty() ? 0 : m_MipLevels[0].width;
+	case TexelFormat::Material: return m_MaterialLevels.empty() ? 0 : m_MaterialLevels[0].width;
+	default: return m_BlockLevels.empty() ? 0 : m_BlockLevels[0].width;
 	}
+}
 
-	if (m_pTexture)
+uint32_t Texture::GetHeight() const
+{
+	switch (m_Format)
 	{
-		m_pTexture->Release();
+	case TexelFormat::RGBA8: return m_MipLevels.empty() ? 0 : m_MipLevels[0].height;
+	case TexelFormat::Material: return m_MaterialLevels.empty() ? 0 : m_MaterialLevels[0].height;
+	default: return m_BlockLevels.empty() ? 0 : m_BlockLevels[0].height;
+	}
+}
+
+uint32_t Texture::GetAmountMipLevels() const
+{
+	switch (m_Format)
+	{
+	case TexelFormat::RGBA8: return uint32_t(m_MipLevels.size());
+	case TexelFormat::Material: return uint32_t(m_MaterialLevels.size());
+	default: return uint32_t(m_BlockLevels.size());
 	}
 }
 
-//=== Functions ===//
 Elite::RGBColor Texture::Sample(const Elite::FVector2& uv) const
 {
-	Elite::RGBColor sample{};
-	Uint8 r{}, g{}, b{};
+	if (GetAmountMipLevels() == 0)
+	{
+		return Elite::RGBColor{};
+	}
+
+	switch (m_Format)
+	{
+	case TexelFormat::BC1: return SamplePoint<BC1Codec>(m_BlockLevels[0], uv);
+	case TexelFormat::BC3: return SamplePoint<BC3Codec>(m_BlockLevels[0], uv);
+	case TexelFormat::BC5: return SamplePoint<BC5Codec>(m_BlockLevels[0], uv);
+	case TexelFormat::Material:
+	{
+		const MaterialColor color{ (m_Layout == TexelLayout::Tiled) ? SamplePoint<TiledAddressing>(m_MaterialLevels[0], uv) : SamplePoint<RowMajorAddressing>(m_MaterialLevels[0], uv) };
+		return Elite::RGBColor{ color.channels[DiffuseR], color.channels[DiffuseG], color.channels[DiffuseB] };
+	}
+	default: return (m_Layout == TexelLayout::Tiled) ? SamplePoint<TiledAddressing>(m_MipLevels[0], uv) : SamplePoint<RowMajorAddressing>(m_MipLevels[0], uv);
+	}
+}
+
+Elite::RGBColor Texture::Sample(const Elite::FVector2& uv, const Elite::FVector2& uvDdx, const Elite::FVector2& uvDdy, MipFilter mipFilter, Mesh::Filter filter) const
+{
+	if (GetAmountMipLevels() == 0)
+	{
+		return Elite::RGBColor{};
+	}
+
+	//Layout and format are picked once per sample, every texel fetch after this is addressed without branching on them
+	switch (m_Format)
+	{
+	case TexelFormat::BC1: return SampleMips<BC1Codec>(m_BlockLevels, uv, uvDdx, uvDdy, mipFilter, filter);
+	case TexelFormat::BC3: return SampleMips<BC3Codec>(m_BlockLevels, uv, uvDdx, uvDdy, mipFilter, filter);
+	case TexelFormat::BC5: return SampleMips<BC5Codec>(m_BlockLevels, uv, uvDdx, uvDdy, mipFilter, filter);
+	case TexelFormat::Material: return SampleMaterial(uv, uvDdx, uvDdy, mipFilter, filter).diffuse;
+	default:
+		return (m_Layout == TexelLayout::Tiled) ? SampleMips<TiledAddressing>(m_MipLevels, uv, uvDdx, uvDdy, mipFilter, filter) :
+			SampleMips<RowMajorAddressing>(m_MipLevels, uv, uvDdx, uvDdy, mipFilter, filter);
+	}
+}
+
+MaterialSample Texture::SampleMaterial(const Elite::FVector2& uv, const Elite::FVector2& uvDdx, const Elite::FVector2& uvDdy, MipFilter mipFilter, Mesh::Filter filter) const
+{
+	if (m_Format != TexelFormat::Material || m_MaterialLevels.empty())
+	{
+		return MaterialSample{};
+	}
+
+	const MaterialColor color{ (m_Layout == TexelLayout::Tiled) ? SampleMips<TiledAddressing>(m_MaterialLevels, uv, uvDdx, uvDdy, mipFilter, filter) :
+		SampleMips<RowMajorAddressing>(m_MaterialLevels, uv, uvDdx, uvDdy, mipFilter, filter) };
+
+	//Normal z is not stored, the tangent space normal points out of the surface so z is always positive
+	const float normalX{ 2.f * color.channels[NormalX] - 1.f };
+	const float normalY{ 2.f * color.channels[NormalY] - 1.f };
+	const float normalZ{ sqrtf(std::max(1.f - normalX * normalX - normalY * normalY, 0.f)) };
+
+	return MaterialSample{ Elite::RGBColor{ color.channels[DiffuseR], color.channels[DiffuseG], color.channels[DiffuseB] },
+		Elite::FVector3{ normalX, normalY, normalZ }, color.channels[Specular], color.channels[Gloss] };
+}
+
+void Texture::SetLayout(TexelLayout layout)
+{
+	if (layout == m_Layout)
+	{
+		return;
+	}
+
+	for (MipLevelRGBA8& level : m_MipLevels)
+	{
+		if (layout == TexelLayout::Tiled)
+		{
+			Relayout<RowMajorAddressing, TiledAddressing>(level);
+		}
+		else
+		{
+			Relayout<TiledAddressing, RowMajorAddressing>(level);
+		}
+	}
+	for (MipLevelMaterial& level : m_MaterialLevels)
+	{
+		if (layout == TexelLayout::Tiled)
+		{
+			Relayout<RowMajorAddressing, TiledAddressing>(level);
+		}
+		else
+		{
+			Relayout<TiledAddressing, RowMajorAddressing>(level);
+		}
+	}
+	m_Layout = layout;
+}
+
+const void* Texture::GetTexelAddress(const Elite::FVector2& uv, uint32_t mipLevel) const
+{
+	if (mipLevel >= GetAmountMipLevels())
+	{
+		return nullptr;
+	}
+
+	uint32_t width{}, height{};
+	switch (m_Format)
+	{
+	case TexelFormat::RGBA8: width = m_MipLevels[mipLevel].width; height = m_MipLevels[mipLevel].height; break;
+	case TexelFormat::Material: width = m_MaterialLevels[mipLevel].width; height = m_MaterialLevels[mipLevel].height; break;
+	default: width = m_BlockLevels[mipLevel].width; height = m_BlockLevels[mipLevel].height; break;
+	}
+	const int x{ int(floorf(uv.x * width)) };
+	const int y{ int(floorf(uv.y * height)) };
+	if (x < 0 || y < 0 || x >= int(width) || y >= int(height))
+	{
+		return nullptr;
+	}
+
+	if (m_Format == TexelFormat::Material)
+	{
+		const MipLevelMaterial& level{ m_MaterialLevels[mipLevel] };
+		const size_t index{ (m_Layout == TexelLayout::Tiled) ? TiledAddressing::Index(level.width, x, y) : RowMajorAddressing::Index(level.width, x, y) };
+		return &level.pTexels[index];
+	}
+
+	//Block compressed -> the block the texel is decoded from
+	if (m_Format != TexelFormat::RGBA8)
+	{
+		const uint32_t blockBytes{ (m_Format == TexelFormat::BC1) ? BC1Codec::blockBytes : BC3Codec::blockBytes };
+		return &m_BlockLevels[mipLevel].pTexels[(size_t(y / 4) * ((width + 3) / 4) + x / 4) * blockBytes];
+	}
+
+	const MipLevelRGBA8& level{ m_MipLevels[mipLevel] };
+	const size_t index{ (m_Layout == TexelLayout::Tiled) ? TiledAddressing::Index(level.width, x, y) : RowMajorAddressing::Index(level.width, x, y) };
+	return &level.pTexels[index];
+}
+
+uint32_t Texture::GetTexel(uint32_t x, uint32_t y) const
+{
+	switch (m_Format)
+	{
+	case TexelFormat::BC1: return FetchTexel<BC1Codec>(m_BlockLevels[0], x, y);
+	case TexelFormat::BC3: return FetchTexel<BC3Codec>(m_BlockLevels[0], x, y);
+	case TexelFormat::BC5: return FetchTexel<BC5Codec>(m_BlockLevels[0], x, y);
+	case TexelFormat::Material:
+	{
+		const MaterialTexel texel{ (m_Layout == TexelLayout::Tiled) ? FetchTexel<TiledAddressing>(m_MaterialLevels[0], x, y) : FetchTexel<RowMajorAddressing>(m_MaterialLevels[0], x, y) };
+		return uint32_t(texel.channels[DiffuseR]) | (uint32_t(texel.channels[DiffuseG]) << 8) | (uint32_t(texel.channels[DiffuseB]) << 16) | 0xFF000000;
+	}
+	default: return (m_Layout == TexelLayout::Tiled) ? FetchTexel<TiledAddressing>(m_MipLevels[0], x, y) : FetchTexel<RowMajorAddressing>(m_MipLevels[0], x, y);
+	}
+}
+
+Texture::Footprint Texture::ComputeFootprint(uint32_t width, uint32_t height, uint32_t amountMipLevels, const Elite::FVector2& uvDdx, const Elite::FVector2& uvDdy, Mesh::Filter filter)
+{
+	//Length of both screen axes in texels of the full resolution level
+	const float w{ float(width) }, h{ float(height) };
+	const float lengthX{ sqrtf((uvDdx.x * w) * (uvDdx.x * w) + (uvDdx.y * h) * (uvDdx.y * h)) };
+	const float lengthY{ sqrtf((uvDdy.x * w) * (uvDdy.x * w) + (uvDdy.y * h) * (uvDdy.y * h)) };
+	const float major{ std::max(lengthX, lengthY) };
+	const float minor{ std::min(lengthX, lengthY) };
+
+	Footprint footprint{ 0.f, 1, Elite::FVector2{} };
+	float texelsPerTap{ major };
+
+	//Anisotropic -> the long axis is covered by several taps, each tap only has to cover the short axis
+	if (filter == Mesh::Filter::Anisotropic && major > 1.f)
+	{
+		//Clamped before converting, major / minor is infinite (or NaN) for degenerate derivatives and that doesn't fit in an integer
+		const float ratio{ (minor > 0.f) ? std::min(float(maxAnisotropy), major / minor) : float(maxAnisotropy) };
+		footprint.amountTaps = uint32_t(ceilf(ratio));
+		texelsPerTap = major / footprint.amountTaps;
+		footprint.uvStep = ((lengthX >= lengthY) ? uvDdx : uvDdy) / float(footprint.amountTaps);
+	}
+
+	if (texelsPerTap > 1.f)
+	{
+		footprint.lod = std::min(log2f(texelsPerTap), float(amountMipLevels - 1));
+	}
+	return footprint;
+}
+
+template <typename Addressing, typename Texel>
+Texture::Decoded<Texel> Texture::SampleMips(const std::vector<MipLevel<Texel>>& levels, const Elite::FVector2& uv, const Elite::FVector2& uvDdx, const Elite::FVector2& uvDdy, MipFilter mipFilter, Mesh::Filter filter)
+{
+	const Footprint footprint{ ComputeFootprint(levels[0].width, levels[0].height, uint32_t(levels.size()), uvDdx, uvDdy, filter) };
+	if (footprint.amountTaps == 1)
+	{
+		return SampleLevels<Addressing>(levels, uv, footprint.lod, mipFilter, filter);
+	}
+
+	//Taps centered on uv, spread evenly over the long axis of the footprint
+	Decoded<Texel> sum{};
+	const float firstTap{ 0.5f - 0.5f * footprint.amountTaps };
+	const float weight{ 1.f / footprint.amountTaps };
+	for (uint32_t i{}; i < footprint.amountTaps; ++i)
+	{
+		Accumulate(sum, SampleLevels<Addressing>(levels, uv + footprint.uvStep * (firstTap + float(i)), footprint.lod, mipFilter, filter), weight);
+	}
+	return sum;
+}
+
+template <typename Addressing, typename Texel>
+Texture::Decoded<Texel> Texture::SampleLevels(const std::vector<MipLevel<Texel>>& levels, const Elite::FVector2& uv, float lod, MipFilter mipFilter, Mesh::Filter filter)
+{
+	//Point filter reads one texel per level, linear and anisotropic read four
+	const auto sampleLevel = [&uv, filter](const MipLevel<Texel>& level)
+	{
+		return (filter == Mesh::Filter::Point) ? SamplePoint<Addressing>(level, uv) : SampleBilinear<Addressing>(level, uv);
+	};
+
+	switch (mipFilter)
+	{
+	case MipFilter::Nearest:
+		return sampleLevel(levels[size_t(lod + 0.5f)]);
+
+	case MipFilter::Trilinear:
+	{
+		const size_t level{ size_t(lod) };
+		const float blend{ lod - float(level) };
+		Decoded<Texel> sample{ sampleLevel(levels[level]) };
+		if (level + 1 >= levels.size() || blend == 0.f)
+		{
+			return sample;
+		}
 
-	uint32_t x = uint32_t(uv.x * m_pSurface->w);
-	uint32_t y = uint32_t(uv.y * m_pSurface->h);
+		Lerp(sample, sampleLevel(levels[level + 1]), blend);
+		return sample;
+	}
+
+	default:
+		return sampleLevel(levels[0]);
+	}
+}
 
-	int index = x + (y * m_pSurface->w);
+void Texture::GenerateMips(SDL_Surface* pSurface)
+{
+	//Level 0 -> surface converted once to RGBA8, no format lookups while sampling
+	SDL_Surface* pConverted{ SDL_ConvertSurfaceFormat(pSurface, SDL_PIXELFORMAT_RGBA32, 0) };
+	if (!pConverted)
+	{
+		std::cout << "Texture not converted properly." << std::endl;
+		return;
+	}
 
-	Uint32* pixels = (Uint32*)m_pSurface->pixels;
-	if (index < m_pSurface->h * m_pSurface->w && index >= 0)
+	MipLevelRGBA8 base{ uint32_t(pConverted->w), uint32_t(pConverted->h), {} };
+	base.texels.resize(size_t(base.width) * base.height);
+	for (uint32_t y{}; y < base.height; ++y)
+	{
+		const uint8_t* pRow{ static_cast<const uint8_t*>(pConverted->pixels) + size_t(y) * pConverted->pitch };
+		std::copy_n(reinterpret_cast<const uint32_t*>(pRow), base.width, base.texels.data() + size_t(y) * base.width);
+	}
+	SDL_FreeSurface(pConverted);
+	base.UseOwnTexels();
+	m_MipLevels.push_back(std::move(base));
+
+	GenerateMips(m_MipLevels);
+}
+
+template <typename Texel>
+void Texture::GenerateMips(std::vector<MipLevel<Texel>>& levels)
+{
+	//Every next level is a 2x2 box filter of the previous one, down to 1x1 (level 0 is row-major)
+	while (levels.back().width > 1 || levels.back().height > 1)
+	{
+		const MipLevel<Texel>& previous{ levels.back() };
+		MipLevel<Texel> level{ std::max(previous.width / 2, 1u), std::max(previous.height / 2, 1u), {} };
+		level.texels.resize(size_t(level.width) * level.height);
+
+		for (uint32_t y{}; y < level.height; ++y)
+		{
+			for (uint32_t x{}; x < level.width; ++x)
+			{
+				//Odd sizes reuse the last row or column
+				const uint32_t x0{ std::min(x * 2, previous.width - 1) }, x1{ std::min(x * 2 + 1, previous.width - 1) };
+				const uint32_t y0{ std::min(y * 2, previous.height - 1) }, y1{ std::min(y * 2 + 1, previous.height - 1) };
+				level.texels[x + size_t(y) * level.width] = AverageTexels(previous.texels[x0 + size_t(y0) * previous.width], previous.texels[x1 + size_t(y0) * previous.width],
+					previous.texels[x0 + size_t(y1) * previous.width], previous.texels[x1 + size_t(y1) * previous.width]);
+			}
+		}
+		level.UseOwnTexels();
+
+		levels.push_back(std::move(level));
+	}
+}
+
+bool Texture::LoadDDS(const std::string& filePath)
+{
+	//Blocks are sampled and uploaded straight from the mapped file
+	if (!m_MappedFile.Open(filePath))
+	{
+		return false;
+	}
+
+	const uint8_t* pData{ m_MappedFile.GetData() };
+	const size_t dataSize{ m_MappedFile.GetSize() };
+	if (dataSize < g_DDSHeaderSize || ReadUInt32(pData, 0) != g_DDSMagic)
+	{
+		m_MappedFile.Close();
+		return false;
+	}
+
+	//DDS_HEADER after the magic, only the fields needed for BCn
+	const uint32_t height{ ReadUInt32(pData, 12) };
+	const uint32_t width{ ReadUInt32(pData, 16) };
+	const uint32_t amountMipLevels{ std::max(ReadUInt32(pData, 28), 1u) };
+	const uint32_t fourCC{ ReadUInt32(pData, 84) };
+
+	size_t offset{ g_DDSHeaderSize };
+	TexelFormat format{ TexelFormat::RGBA8 };
+	if (fourCC == MakeFourCC('D', 'X', 'T', '1'))
+	{
+		format = TexelFormat::BC1;
+	}
+	else if (fourCC == MakeFourCC('D', 'X', 'T', '5'))
+	{
+		format = TexelFormat::BC3;
+	}
+	else if (fourCC == MakeFourCC('A', 'T', 'I', '2') || fourCC == MakeFourCC('B', 'C', '5', 'U'))
+	{
+		format = TexelFormat::BC5;
+	}
+	else if (fourCC == MakeFourCC('D', 'X', '1', '0') && dataSize >= g_DDSHeaderSize + g_DDSHeaderDX10Size)
+	{
+		const uint32_t dxgiFormat{ ReadUInt32(pData, g_DDSHeaderSize) };
+		offset += g_DDSHeaderDX10Size;
+		if (dxgiFormat == DXGI_FORMAT_BC1_UNORM) format = TexelFormat::BC1;
+		else if (dxgiFormat == DXGI_FORMAT_BC3_UNORM) format = TexelFormat::BC3;
+		else if (dxgiFormat == DXGI_FORMAT_BC5_UNORM) format = TexelFormat::BC5;
+	}
+
+	if (format == TexelFormat::RGBA8)
+	{
+		m_MappedFile.Close();
+		return false;
+	}
+
+	//Mip levels follow each other, largest first
+	const uint32_t blockBytes{ (format == TexelFormat::BC1) ? BC1Codec::blockBytes : BC3Codec::blockBytes };
+	for (uint32_t i{}; i < amountMipLevels; ++i)
+	{
+		MipLevelBlocks level{ std::max(width >> i, 1u), std::max(height >> i, 1u), {} };
+		const size_t size{ size_t((level.width + 3) / 4) * ((level.height + 3) / 4) * blockBytes };
+		if (offset + size > dataSize)
+		{
+			break;
+		}
+
+		level.pTexels = pData + offset;
+		level.amountTexels = size;
+		offset += size;
+		m_BlockLevels.push_back(std::move(level));
+	}
+
+	if (m_BlockLevels.empty())
+	{
+		m_MappedFile.Close();
+		return false;
+	}
+	m_Format = format;
+	return true;
+}
+
+bool Texture::LoadCooked(const std::string& filePath)
+{
+	const int64_t sourceTime{ Elite::GetSourceTime(filePath) };
+	if (sourceTime == 0 || !m_MappedFile.Open(filePath + ".cooked"))
+	{
+		return false;
+	}
+
+	//Anything that doesn't match (older source, other version, truncated file) -> decode the source again
+	const uint8_t* pData{ m_MappedFile.GetData() };
+	const size_t dataSize{ m_MappedFile.GetSize() };
+	CookedTextureHeader header{};
+	if (dataSize >= sizeof(header))
+	{
+		std::memcpy(&header, pData, sizeof(header));
+	}
+
+	const size_t tableOffset{ Elite::AlignCooked(sizeof(header) + header.cooked.sourcePathSize) };
+	const bool isValid{ Elite::IsCookedCurrent(header.cooked, g_CookedMagic, g_CookedVersion, sourceTime, filePath, pData, dataSize, sizeof(header))
+		&& header.amountMipLevels > 0 && Elite::IsCookedRange(tableOffset, header.amountMipLevels, sizeof(CookedMipLevel), dataSize) };
+	if (!isValid)
+	{
+		m_MappedFile.Close();
+		return false;
+	}
+
+	for (uint32_t i{}; i < header.amountMipLevels; ++i)
+	{
+		CookedMipLevel cookedLevel{};
+		std::memcpy(&cookedLevel, pData + tableOffset + i * sizeof(CookedMipLevel), sizeof(cookedLevel));
+
+		MipLevelRGBA8 level{ cookedLevel.width, cookedLevel.height, {} };
+		level.amountTexels = size_t(level.width) * level.height;
+		if (cookedLevel.offset % Elite::cookedAlignment != 0 || !Elite::IsCookedRange(cookedLevel.offset, level.amountTexels, sizeof(uint32_t), dataSize))
+		{
+			m_MipLevels.clear();
+			m_MappedFile.Close();
+			return false;
+		}
+
+		level.pTexels = reinterpret_cast<const uint32_t*>(pData + cookedLevel.offset);
+		m_MipLevels.push_back(std::move(level));
+	}
+	return true;
+}
+
+void Texture::SaveCooked(const std::string& filePath) const
+{
+	const int64_t sourceTime{ Elite::GetSourceTime(filePath) };
+	if (sourceTime == 0 || m_MipLevels.empty())
+	{
+		return;
+	}
+
+	const CookedTextureHeader header{ { g_CookedMagic, g_CookedVersion, sourceTime, uint32_t(filePath.size()) }, uint32_t(m_MipLevels.size()) };
+
+	//Offsets first, the texels of every level start on a cache line
+	std::vector<CookedMipLevel> table{};
+	size_t offset{ Elite::AlignCooked(Elite::AlignCooked(sizeof(header) + filePath.size()) + m_MipLevels.size() * sizeof(CookedMipLevel)) };
+	for (const MipLevelRGBA8& level : m_MipLevels)
+	{
+		table.push_back(CookedMipLevel{ level.width, level.height, offset });
+		offset = Elite::AlignCooked(offset + level.amountTexels * sizeof(uint32_t));
+	}
+
+	//Written next to the source, a failed write only costs the next start a decode
+	CookedWriter writer{ filePath + ".cooked" };
+	writer.Write(&header, sizeof(header));
+	writer.Write(filePath.data(), filePath.size());
+	writer.PadTo(Elite::AlignCooked(sizeof(header) + filePath.size()));
+	writer.Write(table.data(), table.size() * sizeof(CookedMipLevel));
+	for (size_t i{}; i < m_MipLevels.size(); ++i)
+	{
+		writer.PadTo(table[i].offset);
+		writer.Write(m_MipLevels[i].pTexels, m_MipLevels[i].amountTexels * sizeof(uint32_t));
+	}
+
+	if (!writer.Commit())
+	{
+		std::cout << "Texture not cooked properly." << std::endl;
+	}
+}
+
+void Texture::DecodeBlock(TexelFormat format, const uint8_t* pBlock, uint32_t texels[16])
+{
+	switch (format)
+	{
+	case TexelFormat::BC1: BC1Codec::Decode(pBlock, texels); break;
+	case TexelFormat::BC3: BC3Codec::Decode(pBlock, texels); break;
+	case TexelFormat::BC5: BC5Codec::Decode(pBlock, texels); break;
+	default: std::fill_n(texels, 16, 0u); break;
+	}
+}
+
+void Texture::BC1Codec::Decode(const uint8_t* pBlock, uint32_t texels[16])
+{
+	DecodeColorBlock(pBlock, true, texels);
+}
+
+void Texture::BC3Codec::Decode(const uint8_t* pBlock, uint32_t texels[16])
+{
+	//Alpha block, then a color block that always uses 4 colors
+	uint8_t alpha[16];
+	DecodeScalarBlock(pBlock, alpha);
+	DecodeColorBlock(pBlock + 8, false, texels);
+	for (uint32_t i{}; i < 16; ++i)
+	{
+		texels[i] = (texels[i] & 0x00FFFFFF) | (uint32_t(alpha[i]) << 24);
+	}
+}
+
+void Texture::BC5Codec::Decode(const uint8_t* pBlock, uint32_t texels[16])
+{
+	//Red and green blocks, blue is left zero (reconstructed by whoever reads a normal from it)
+	uint8_t red[16], green[16];
+	DecodeScalarBlock(pBlock, red);
+	DecodeScalarBlock(pBlock + 8, green);
+	for (uint32_t i{}; i < 16; ++i)
+	{
+		texels[i] = uint32_t(red[i]) | (uint32_t(green[i]) << 8) | 0xFF000000;
+	}
+}
+
+Elite::RGBColor Texture::DecodeTexel(uint32_t texel)
+{
+	return Elite::RGBColor{ g_ByteToFloat.values[texel & 0xFF], g_ByteToFloat.values[(texel >> 8) & 0xFF], g_ByteToFloat.values[(texel >> 16) & 0xFF] };
+}
+
+Texture::MaterialColor Texture::DecodeTexel(const MaterialTexel& texel)
+{
+	__m128 low, high;
+	UnpackTexel(texel.channels, low, high);
+
+	const __m128 scale{ _mm_set1_ps(1.f / 255.f) };
+	MaterialColor color;
+	_mm_store_ps(color.channels, _mm_mul_ps(low, scale));
+	_mm_store_ps(color.channels + 4, _mm_mul_ps(high, scale));
+	return color;
+}
+
+Elite::RGBColor Texture::BlendBilinear(uint32_t texel00, uint32_t texel10, uint32_t texel01, uint32_t texel11, float weightX, float weightY)
+{
+	//All channels at once
+	alignas(16) float channels[4];
+	_mm_store_ps(channels, BlendTexels(UnpackTexel(texel00), UnpackTexel(texel10), UnpackTexel(texel01), UnpackTexel(texel11), _mm_set1_ps(weightX), _mm_set1_ps(weightY)));
+	return Elite::RGBColor{ channels[0], channels[1], channels[2] };
+}
+
+Texture::MaterialColor Texture::BlendBilinear(const MaterialTexel& texel00, const MaterialTexel& texel10, const MaterialTexel& texel01, const MaterialTexel& texel11, float weightX, float weightY)
+{
+	//Four channels per register
+	__m128 low00, high00, low10, high10, low01, high01, low11, high11;
+	UnpackTexel(texel00.channels, low00, high00);
+	UnpackTexel(texel10.channels, low10, high10);
+	UnpackTexel(texel01.channels, low01, high01);
+	UnpackTexel(texel11.channels, low11, high11);
+
+	const __m128 blendX{ _mm_set1_ps(weightX) }, blendY{ _mm_set1_ps(weightY) };
+	MaterialColor color;
+	_mm_store_ps(color.channels, BlendTexels(low00, low10, low01, low11, blendX, blendY));
+	_mm_store_ps(color.channels + 4, BlendTexels(high00, high10, high01, high11, blendX, blendY));
+	return color;
+}
+
+uint32_t Texture::AverageTexels(uint32_t texel00, uint32_t texel10, uint32_t texel01, uint32_t texel11)
+{
+	uint32_t result{};
+	for (uint32_t shift{}; shift < 32; shift += 8)
+	{
+		const uint32_t sum{ ((texel00 >> shift) & 0xFF) + ((texel10 >> shift) & 0xFF) + ((texel01 >> shift) & 0xFF) + ((texel11 >> shift) & 0xFF) };
+		result |= ((sum + 2) / 4) << shift;
+	}
+	return result;
+}
+
+Texture::MaterialTexel Texture::AverageTexels(const MaterialTexel& texel00, const MaterialTexel& texel10, const MaterialTexel& texel01, const MaterialTexel& texel11)
+{
+	MaterialTexel result{};
+	for (int i{}; i < AmountMaterialChannels; ++i)
+	{
+		result.channels[i] = uint8_t((texel00.channels[i] + texel10.channels[i] + texel01.channels[i] + texel11.channels[i] + 2) / 4);
+	}
+	return result;
+}
+
+void Texture::Lerp(Elite::RGBColor& a, const Elite::RGBColor& b, float t)
+{
+	a += (b - a) * t;
+}
+
+void Texture::Lerp(MaterialColor& a, const MaterialColor& b, float t)
+{
+	const __m128 weight{ _mm_set1_ps(t) };
+	for (int i{}; i < 8; i += 4)
+	{
+		const __m128 from{ _mm_load_ps(a.channels + i) };
+		_mm_store_ps(a.channels + i, _mm_add_ps(from, _mm_mul_ps(_mm_sub_ps(_mm_load_ps(b.channels + i), from), weight)));
+	}
+}
+
+void Texture::Accumulate(Elite::RGBColor& sum, const Elite::RGBColor& color, float weight)
+{
+	sum += color * weight;
+}
+
+void Texture::Accumulate(MaterialColor& sum, const MaterialColor& color, float weight)
+{
+	const __m128 scale{ _mm_set1_ps(weight) };
+	for (int i{}; i < 8; i += 4)
+	{
+		_mm_store_ps(sum.channels + i, _mm_add_ps(_mm_load_ps(sum.channels + i), _mm_mul_ps(_mm_load_ps(color.channels + i), scale)));
+	}
+}
+
+template <typename Addressing>
+uint32_t Texture::FetchTexel(const MipLevelRGBA8& level, int x, int y)
+{
+	//Border addressing (black), same as the hardware samplers
+	if (x < 0 || y < 0 || x >= int(level.width) || y >= int(level.height))
+	{
+		return 0;
+	}
+
+	return level.pTexels[Addressing::Index(level.width, x, y)];
+}
+
+template <typename Addressing>
+Texture::MaterialTexel Texture::FetchTexel(const MipLevelMaterial& level, int x, int y)
+{
+	//Border addressing (all channels zero)
+	if (x < 0 || y < 0 || x >= int(level.width) || y >= int(level.height))
+	{
+		return MaterialTexel{};
+	}
+
+	return level.pTexels[Addressing::Index(level.width, x, y)];
+}
+
+template <typename Codec>
+uint32_t Texture::FetchTexel(const MipLevelBlocks& level, int x, int y)
+{
+	//Border addressing (black), same as the hardware samplers
+	if (x < 0 || y < 0 || x >= int(level.width) || y >= int(level.height))
+	{
+		return 0;
+	}
+
+	//Neighbouring samples mostly hit the same block, it is only decoded when it is not cached yet
+	const uint8_t* pBlock{ level.pTexels + (size_t(y / 4) * ((level.width + 3) / 4) + x / 4) * Codec::blockBytes };
+	const size_t entry{ (reinterpret_cast<uintptr_t>(pBlock) / Codec::blockBytes) % BlockCache::amountEntries };
+	BlockCache& cache{ g_BlockCache };
+	if (cache.pBlocks[entry] != pBlock)
+	{
+		Codec::Decode(pBlock, cache.texels[entry]);
+		cache.pBlocks[entry] = pBlock;
+	}
+
+	return cache.texels[entry][(y % 4) * 4 + (x % 4)];
+}
+
+template <typename Addressing, typename Texel>
+Texture::Decoded<Texel> Texture::Fetch(const MipLevel<Texel>& level, int x, int y)
+{
+	return DecodeTexel(FetchTexel<Addressing>(level, x, y));
+}
+
+template <typename Addressing, typename Texel>
+Texture::Decoded<Texel> Texture::SamplePoint(const MipLevel<Texel>& level, const Elite::FVector2& uv)
+{
+	return Fetch<Addressing>(level, int(floorf(uv.x * level.width)), int(floorf(uv.y * level.height)));
+}
+
+template <typename Addressing, typename Texel>
+Texture::Decoded<Texel> Texture::SampleBilinear(const MipLevel<Texel>& level, const Elite::FVector2& uv)
+{
+	//Texel centers sit at half coordinates
+	const float u{ uv.x * level.width - 0.5f };
+	const float v{ uv.y * level.height - 0.5f };
+	const float x0{ floorf(u) }, y0{ floorf(v) };
+
+	//Blend the four texels around uv
+	const int x{ int(x0) }, y{ int(y0) };
+	return BlendBilinear(FetchTexel<Addressing>(level, x, y), FetchTexel<Addressing>(level, x + 1, y),
+		FetchTexel<Addressing>(level, x, y + 1), FetchTexel<Addressing>(level, x + 1, y + 1), u - x0, v - y0);
+}
+
+template <typename From, typename To, typename Texel>
+void Texture::Relayout(MipLevel<Texel>& level)
+{
+	//Padding texels of tiled levels (partial blocks) stay zero
+	TexelVector<Texel> texels(To::Size(level.width, level.height));
+	for (uint32_t y{}; y < level.height; ++y)
 	{
-		SDL_GetRGB(pixels[index], m_pSurface->format, &r, &g, &b);
+		for (uint32_t x{}; x < level.width; ++x)
+		{
+			texels[To::Index(level.width, x, y)] = level.pTexels[From::Index(level.width, x, y)];
+		}
 	}
 
-	sample = Elite::RGBColor(float(r / 255.f), float(g / 255.f), float(b / 255.f));
-	return sample;
+	//Mapped levels get their own copy here
+	level.texels = std::move(texels);
+	level.UseOwnTexels();
 }
\ No newline at end of file
@@ -1,21 +1,96 @@
 #pragma once
 
 #include <string>
+#include <vector>
+#include <type_traits>
 
 #include "EMath.h"
 #include "ERGBColor.h"
+#include "Mesh.h"
+#include "MappedFile.h"
+#include "AlignedAllocator.h"
 
 struct SDL_Surface;
 struct ID3D11Texture2D;
 struct ID3D11ShaderResourceView;
 
+//=== MaterialSample struct ===//
+struct MaterialSample
+{
+	Elite::RGBColor diffuse;
+	Elite::FVector3 normal; //Tangent space, [-1, 1], z reconstructed from x and y
+	float specular;
+	float gloss;
+};
+
 //=== Texture class ===//
 class Texture final
 {
 public:
+	//=== MipFilter enum class ===//
+	//Which mip levels are read, how texels inside a level are filtered is the Mesh::Filter (same as the hardware samplers)
+	enum class MipFilter
+	{
+		None = 0, //Full resolution only
+		Nearest = 1, //Closest mip level
+		Trilinear = 2, //Two closest mip levels, blended (trilinear together with Mesh::Filter::Linear)
+		Count = 3,
+	};
+
+	//=== Footprint struct ===//
+	//Screen pixel projected into the texture, anisotropic filtering spreads amountTaps samples uvStep apart along its long axis
+	struct Footprint
+	{
+		float lod;
+		uint32_t amountTaps;
+		Elite::FVector2 uvStep;
+	};
+	static const uint32_t maxAnisotropy{ 16 };
+
+	//=== TexelFormat enum class ===//
+	enum class TexelFormat
+	{
+		RGBA8 = 0, //Decoded at load (PNG, ...)
+		BC1 = 1, //DDS, RGB in 8 byte 4x4 blocks
+		BC3 = 2, //DDS, RGBA in 16 byte 4x4 blocks
+		BC5 = 3, //DDS, two channels (normal XY) in 16 byte 4x4 blocks
+		Material = 4, //Software only, diffuse, normal, specular and gloss maps interleaved in one 8 byte texel
+	};
+
+	//=== TexelLayout enum class ===//
+	enum class TexelLayout
+	{
+		RowMajor = 0,
+		Tiled = 1, //4x4 texel blocks, one block is one 64 byte cache line (level storage is 64 byte aligned)
+	};
+
+	//=== Addressing ===//
+	//Texel index inside a mip level for each layout, the sampler is templated on these
+	struct RowMajorAddressing
+	{
+		static size_t Index(uint32_t width, uint32_t x, uint32_t y) { return x + size_t(y) * width; }
+		static size_t Size(uint32_t width, uint32_t height) { return size_t(width) * height; }
+	};
+	struct TiledAddressing
+	{
+		static const uint32_t blockSize{ 4 };
+		static size_t Index(uint32_t width, uint32_t x, uint32_t y)
+		{
+			const uint32_t amountBlocksX{ (width + blockSize - 1) / blockSize };
+			return (size_t(y / blockSize) * amountBlocksX + x / blockSize) * (blockSize * blockSize) + (y % blockSize) * blockSize + (x % blockSize);
+		}
+		static size_t Size(uint32_t width, uint32_t height) { return size_t((width + blockSize - 1) / blockSize) * ((height + blockSize - 1) / blockSize) * (blockSize * blockSize); }
+	};
+
 	//=== Constructor ===//
+	//.dds files keep their BCn blocks (uploaded as is, decoded per block while sampling), everything else goes through SDL_image
+	//once and is cooked next to the source (filePath.cooked), later runs map the cooked texels without decoding
+	//Only touches the file and its own memory, so several can be loaded at once on different threads
 	Texture(std::string filePath);
 	Texture(const char* filepath, ID3D11Device* pDevice);
+	//Material texture, shading reads one texel (one cache line) instead of four, all maps have to be decoded (RGBA8)
+	//Missing maps get neutral values (flat normal, no specular), maps of another size are resampled to the diffuse size
+	Texture(const Texture& diffuse, const Texture* pNormal, const Texture* pSpecular, const Texture* pGloss);
 
 	//=== Rule of five ===//
 	~Texture();
@@ -25,13 +100,147 @@ public:
 	Texture& operator=(Texture&& texture) = delete;
 
 	//=== Functions ===//
+	//Uploads the loaded mip chain, for textures made without a device (call from the thread that owns the device)
+	void CreateHardwareTexture(ID3D11Device* pDevice);
+	//Drops the software copy of the texels (and the mapped file), for textures only sampled by the hardware from now on
+	void ReleaseTexels();
 	ID3D11ShaderResourceView* GetResourceView() const { return m_pResourceView; }
+	TexelFormat GetFormat() const { return m_Format; }
+	uint32_t GetWidth() const;
+	uint32_t GetHeight() const;
+	uint32_t GetAmountMipLevels() const;
+	//RGBA8 texel of the full resolution level (red in the lowest byte, blocks are decoded), for load-time repacking
+	uint32_t GetTexel(uint32_t x, uint32_t y) const;
 
 	Elite::RGBColor Sample(const Elite::FVector2& uv) const;
+	//uvDdx and uvDdy are the screen space derivatives of uv (from a 2x2 pixel quad), they pick the mip level and the anisotropic footprint
+	Elite::RGBColor Sample(const Elite::FVector2& uv, const Elite::FVector2& uvDdx, const Elite::FVector2& uvDdy, MipFilter mipFilter, Mesh::Filter filter) const;
+	//Material textures only, Sample returns their diffuse color
+	MaterialSample SampleMaterial(const Elite::FVector2& uv, const Elite::FVector2& uvDdx, const Elite::FVector2& uvDdy, MipFilter mipFilter, Mesh::Filter filter) const;
+
+	//Software storage only, the hardware texture is uploaded row-major when the texture is created
+	//Block compressed textures ignore this, their blocks already are 4x4 tiles
+	TexelLayout GetLayout() const { return m_Layout; }
+	void SetLayout(TexelLayout layout);
+
+	//Address of the texel a point sample at uv in mipLevel reads, nullptr outside the texture (cache benchmarks)
+	const void* GetTexelAddress(const Elite::FVector2& uv, uint32_t mipLevel) const;
+
+	//Shared with other software samplers
+	static Footprint ComputeFootprint(uint32_t width, uint32_t height, uint32_t amountMipLevels, const Elite::FVector2& uvDdx, const Elite::FVector2& uvDdy, Mesh::Filter filter);
+	//One 4x4 block of a block compressed format to RGBA8 texels (row by row), what sampling decodes (known-block self tests)
+	static void DecodeBlock(TexelFormat format, const uint8_t* pBlock, uint32_t texels[16]);
 
 private:
+	//=== MipLevel struct ===//
+	//Texels are decoded once at load into a fixed layout, the sampler is templated on it so sampling never looks at a pixel format
+	static const size_t texelAlignment{ 64 }; //Cache line, cooked files align their levels the same way
+	template <typename Texel>
+	using TexelVector = std::vector<Texel, AlignedAllocator<Texel, texelAlignment>>;
+
+	template <typename Texel>
+	struct MipLevel
+	{
+		uint32_t width;
+		uint32_t height;
+		TexelVector<Texel> texels; //Empty when the level points into a mapped file
+		const Texel* pTexels; //What gets sampled, texels or the mapped file
+		size_t amountTexels;
+
+		void UseOwnTexels() { pTexels = texels.data(); amountTexels = texels.size(); }
+	};
+	typedef MipLevel<uint32_t> MipLevelRGBA8; //Red in the lowest byte, decoded through a 256 entry float table
+	typedef MipLevel<uint8_t> MipLevelBlocks; //BCn blocks row by row, width and height in texels
+
+	//=== Material texels ===//
+	enum MaterialChannel
+	{
+		DiffuseR = 0,
+		DiffuseG = 1,
+		DiffuseB = 2,
+		NormalX = 3,
+		NormalY = 4,
+		Specular = 5,
+		Gloss = 6,
+		AmountMaterialChannels = 7,
+	};
+	struct MaterialTexel
+	{
+		uint8_t channels[8]; //Last byte is padding, keeps texels 8 byte aligned
+	};
+	struct alignas(16) MaterialColor
+	{
+		float channels[8]; //Same layout as MaterialTexel in [0, 1], filtered as two groups of four
+	};
+	typedef MipLevel<MaterialTexel> MipLevelMaterial;
+
+	//What sampling a level gives, RGBA8 and block compressed levels decode to a color
+	template <typename Texel>
+	using Decoded = std::conditional_t<std::is_same<Texel, MaterialTexel>::value, MaterialColor, Elite::RGBColor>;
+
+	//=== Codecs ===//
+	//Take the place of the addressing for block compressed levels, decode one 4x4 block to RGBA8 texels (row by row)
+	struct BC1Codec
+	{
+		static const uint32_t blockBytes{ 8 };
+		static void Decode(const uint8_t* pBlock, uint32_t texels[16]);
+	};
+	struct BC3Codec
+	{
+		static const uint32_t blockBytes{ 16 };
+		static void Decode(const uint8_t* pBlock, uint32_t texels[16]);
+	};
+	struct BC5Codec
+	{
+		static const uint32_t blockBytes{ 16 };
+		static void Decode(const uint8_t* pBlock, uint32_t texels[16]);
+	};
+
+	//=== Functions ===//
+	void GenerateMips(SDL_Surface* pSurface);
+	template <typename Texel>
+	static void GenerateMips(std::vector<MipLevel<Texel>>& levels);
+	bool LoadDDS(const std::string& filePath);
+	bool LoadCooked(const std::string& filePath);
+	void SaveCooked(const std::string& filePath) const;
+	template <typename Addressing, typename Texel>
+	static Decoded<Texel> SampleMips(const std::vector<MipLevel<Texel>>& levels, const Elite::FVector2& uv, const Elite::FVector2& uvDdx, const Elite::FVector2& uvDdy, MipFilter mipFilter, Mesh::Filter filter);
+	template <typename Addressing, typename Texel>
+	static Decoded<Texel> SampleLevels(const std::vector<MipLevel<Texel>>& levels, const Elite::FVector2& uv, float lod, MipFilter mipFilter, Mesh::Filter filter);
+	template <typename Addressing>
+	static uint32_t FetchTexel(const MipLevelRGBA8& level, int x, int y);
+	template <typename Addressing>
+	static MaterialTexel FetchTexel(const MipLevelMaterial& level, int x, int y);
+	template <typename Codec>
+	static uint32_t FetchTexel(const MipLevelBlocks& level, int x, int y);
+	template <typename Addressing, typename Texel>
+	static Decoded<Texel> Fetch(const MipLevel<Texel>& level, int x, int y);
+	template <typename Addressing, typename Texel>
+	static Decoded<Texel> SamplePoint(const MipLevel<Texel>& level, const Elite::FVector2& uv);
+	template <typename Addressing, typename Texel>
+	static Decoded<Texel> SampleBilinear(const MipLevel<Texel>& level, const Elite::FVector2& uv);
+	template <typename From, typename To, typename Texel>
+	static void Relayout(MipLevel<Texel>& level);
+
+	//Per texel type, all the templates above need
+	static Elite::RGBColor DecodeTexel(uint32_t texel);
+	static MaterialColor DecodeTexel(const MaterialTexel& texel);
+	static Elite::RGBColor BlendBilinear(uint32_t texel00, uint32_t texel10, uint32_t texel01, uint32_t texel11, float weightX, float weightY);
+	static MaterialColor BlendBilinear(const MaterialTexel& texel00, const MaterialTexel& texel10, const MaterialTexel& texel01, const MaterialTexel& texel11, float weightX, float weightY);
+	static uint32_t AverageTexels(uint32_t texel00, uint32_t texel10, uint32_t texel01, uint32_t texel11);
+	static MaterialTexel AverageTexels(const MaterialTexel& texel00, const MaterialTexel& texel10, const MaterialTexel& texel01, const MaterialTexel& texel11);
+	static void Lerp(Elite::RGBColor& a, const Elite::RGBColor& b, float t);
+	static void Lerp(MaterialColor& a, const MaterialColor& b, float t);
+	static void Accumulate(Elite::RGBColor& sum, const Elite::RGBColor& color, float weight);
+	static void Accumulate(MaterialColor& sum, const MaterialColor& color, float weight);
+
 	//=== Variables ===//
-	SDL_Surface* m_pSurface;
+	std::vector<MipLevelRGBA8> m_MipLevels;
+	std::vector<MipLevelBlocks> m_BlockLevels;
+	std::vector<MipLevelMaterial> m_MaterialLevels;
+	TexelFormat m_Format;
+	TexelLayout m_Layout;
+	MappedFile m_MappedFile; //Cooked or .dds file the mip levels point into, open as long as the texture lives
 	ID3D11Texture2D* m_pTexture;
 	ID3D11ShaderResourceView* m_pResourceView;
 };
\ No newline at end of file
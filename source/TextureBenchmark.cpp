@@ -0,0 +1,172 @@
+#include "pch.h"
+
+#include <chrono>
+#include <cstring>
+
+#include "TextureBenchmark.h"
+#include "Texture.h"
+
+//=== Helpers ===//
+namespace
+{
+	//=== CacheModel class ===//
+	//Set associative LRU cache, sized like a typical L1 data cache (32KB, 64 byte lines, 8 ways)
+	class CacheModel final
+	{
+	public:
+		//=== Constructor ===//
+		CacheModel()
+			: m_Tags{}
+			, m_LastUsed{}
+			, m_Time{}
+		{
+			std::memset(m_Tags, 0xFF, sizeof(m_Tags));
+		}
+
+		//=== Functions ===//
+		//Returns true on a miss
+		bool Access(const void* pAddress)
+		{
+			const uintptr_t line{ reinterpret_cast<uintptr_t>(pAddress) / m_LineSize };
+			const uint32_t set{ uint32_t(line % m_AmountSets) };
+			++m_Time;
+
+			uint32_t oldestWay{};
+			for (uint32_t way{}; way < m_AmountWays; ++way)
+			{
+				if (m_Tags[set][way] == line)
+				{
+					m_LastUsed[set][way] = m_Time;
+					return false;
+				}
+
+				if (m_LastUsed[set][way] < m_LastUsed[set][oldestWay])
+				{
+					oldestWay = way;
+				}
+			}
+
+			m_Tags[set][oldestWay] = line;
+			m_LastUsed[set][oldestWay] = m_Time;
+			return true;
+		}
+
+	private:
+		//=== Variables ===//
+		static const uint32_t m_LineSize{ 64 };
+		static const uint32_t m_AmountWays{ 8 };
+		static const uint32_t m_AmountSets{ 32 * 1024 / (m_LineSize * m_AmountWays) };
+
+		uintptr_t m_Tags[m_AmountSets][m_AmountWays];
+		uint64_t m_LastUsed[m_AmountSets][m_AmountWays];
+		uint64_t m_Time;
+	};
+
+	//Keeps the sampling loop from being optimized away
+	volatile float g_Sink{};
+
+	//=== Walk ===//
+	const uint32_t g_WalkSize{ 512 };
+	const float g_WalkAngles[]{ 0.f, 30.f, 45.f, 90.f };
+
+	//Calls function(uv, uvDdx, uvDdy) for every pixel of a g_WalkSize x g_WalkSize screen rotated by angle around the texture center,
+	//one screen row covers stretch texel rows
+	template <typename Function>
+	void Walk(const Texture& texture, float angle, Function function, float stretch = 1.f)
+	{
+		const float radians{ Elite::ToRadians(angle) };
+		const Elite::FVector2 uvDdx{ cosf(radians) / texture.GetWidth(), sinf(radians) / texture.GetHeight() };
+		const Elite::FVector2 uvDdy{ -sinf(radians) * stretch / texture.GetWidth(), cosf(radians) * stretch / texture.GetHeight() };
+		const float halfSize{ g_WalkSize * 0.5f };
+
+		for (uint32_t y{}; y < g_WalkSize; ++y)
+		{
+			for (uint32_t x{}; x < g_WalkSize; ++x)
+			{
+				const Elite::FVector2 uv{ 0.5f + uvDdx.x * (x - halfSize) + uvDdy.x * (y - halfSize), 0.5f + uvDdx.y * (x - halfSize) + uvDdy.y * (y - halfSize) };
+				function(uv, uvDdx, uvDdy);
+			}
+		}
+	}
+}
+
+//=== Functions ===//
+void Elite::BenchmarkTextureLayouts(Texture& texture)
+{
+	if (texture.GetWidth() == 0)
+	{
+		return;
+	}
+
+	const Texture::TexelLayout originalLayout{ texture.GetLayout() };
+	const Texture::TexelLayout layouts[2]{ Texture::TexelLayout::RowMajor, Texture::TexelLayout::Tiled };
+	const char* layoutNames[2]{ "row-major", "tiled 4x4" };
+
+	std::cout << "--- Texture layout benchmark (" << texture.GetWidth() << "x" << texture.GetHeight() << ", " << g_WalkSize << "x" << g_WalkSize << " samples per angle) ---" << std::endl;
+	for (int i{}; i < 2; ++i)
+	{
+		texture.SetLayout(layouts[i]);
+
+		for (float angle : g_WalkAngles)
+		{
+			//Simulated cache misses of the point sampled texels
+			CacheModel cache{};
+			uint64_t misses{};
+			Walk(texture, angle, [&](const Elite::FVector2& uv, const Elite::FVector2&, const Elite::FVector2&)
+				{
+					const void* pTexel{ texture.GetTexelAddress(uv, 0) };
+					if (pTexel && cache.Access(pTexel))
+					{
+						++misses;
+					}
+				});
+
+			//Throughput of the real (trilinear) sampler
+			float sink{};
+			const auto start{ std::chrono::high_resolution_clock::now() };
+			Walk(texture, angle, [&](const Elite::FVector2& uv, const Elite::FVector2& uvDdx, const Elite::FVector2& uvDdy)
+				{
+					sink += texture.Sample(uv, uvDdx, uvDdy, Texture::MipFilter::Trilinear, Mesh::Filter::Linear).r;
+				});
+			const std::chrono::duration<double> seconds{ std::chrono::high_resolution_clock::now() - start };
+			g_Sink = sink;
+
+			const double amountSamples{ double(g_WalkSize) * g_WalkSize };
+			std::cout << layoutNames[i] << "\t" << angle << " deg:\t" << uint64_t(amountSamples / seconds.count()) << " samples/s,\t"
+				<< double(misses) * 1000.0 / amountSamples << " L1 misses per 1000 samples" << std::endl;
+		}
+	}
+
+	texture.SetLayout(originalLayout);
+}
+
+void Elite::BenchmarkTextureFilters(const Texture& texture)
+{
+	if (texture.GetWidth() == 0)
+	{
+		return;
+	}
+
+	const Mesh::Filter filters[3]{ Mesh::Filter::Point, Mesh::Filter::Linear, Mesh::Filter::Anisotropic };
+	const char* filterNames[3]{ "point", "linear", "anisotropic" };
+	const float stretches[2]{ 1.f, 4.f };
+
+	std::cout << "--- Texture filter benchmark (" << texture.GetWidth() << "x" << texture.GetHeight() << ", " << g_WalkSize << "x" << g_WalkSize << " pixels, 30 deg) ---" << std::endl;
+	for (float stretch : stretches)
+	{
+		for (int i{}; i < 3; ++i)
+		{
+			float sink{};
+			const auto start{ std::chrono::high_resolution_clock::now() };
+			Walk(texture, 30.f, [&](const Elite::FVector2& uv, const Elite::FVector2& uvDdx, const Elite::FVector2& uvDdy)
+				{
+					sink += texture.Sample(uv, uvDdx, uvDdy, Texture::MipFilter::Trilinear, filters[i]).r;
+				}, stretch);
+			const std::chrono::duration<double> seconds{ std::chrono::high_resolution_clock::now() - start };
+			g_Sink = sink;
+
+			const double amountPixels{ double(g_WalkSize) * g_WalkSize };
+			std::cout << filterNames[i] << "\t1:" << stretch << " footprint:\t" << seconds.count() * 1e9 / amountPixels << " ns per pixel" << std::endl;
+		}
+	}
+}
@@ -0,0 +1,13 @@
+#pragma once
+
+class Texture;
+
+namespace Elite
+{
+	//=== Functions ===//
+	//Walks a rotated, screen sized grid of uvs over the texture (1 texel per pixel) in every texel layout,
+	//prints samples per second and the misses of a simulated L1 cache, the layout of the texture is restored afterwards
+	void BenchmarkTextureLayouts(Texture& texture);
+	//Cost per pixel of every Mesh::Filter (trilinear mips), on the same grid and on one squashed 4 times vertically (anisotropic footprint)
+	void BenchmarkTextureFilters(const Texture& texture);
+}
@@ -0,0 +1,106 @@
+#include "pch.h"
+
+#include "ThreadPool.h"
+
+//=== Constructor ===//
+ThreadPool::ThreadPool(uint32_t amountThreads)
+	: m_Threads{}
+	, m_pJob{ nullptr }
+	, m_AmountJobs{}
+	, m_NextJob{}
+	, m_AmountBusy{}
+	, m_Generation{}
+	, m_IsStopping{ false }
+{
+	//hardware_concurrency is allowed to return 0
+	amountThreads = std::max(amountThreads, 1u);
+
+	for (uint32_t i{ 1 }; i < amountThreads; ++i)
+	{
+		m_Threads.emplace_back(&ThreadPool::WorkerLoop, this);
+	}
+}
+
+//=== Destructor ===//
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock{ m_Mutex };
+		m_IsStopping = true;
+	}
+	m_StartCondition.notify_all();
+
+	for (std::thread& thread : m_Threads)
+	{
+		thread.join();
+	}
+}
+
+//=== Functions ===//
+void ThreadPool::ParallelFor(uint32_t amountJobs, const std::function<void(uint32_t)>& job)
+{
+	if (amountJobs == 0)
+	{
+		return;
+	}
+
+	//Publish the jobs and wake up the workers
+	{
+		std::lock_guard<std::mutex> lock{ m_Mutex };
+		m_pJob = &job;
+		m_AmountJobs = amountJobs;
+		m_NextJob = 0;
+		m_AmountBusy = uint32_t(m_Threads.size());
+		++m_Generation;
+	}
+	m_StartCondition.notify_all();
+
+	//Help out instead of idling
+	RunJobs();
+
+	//Wait for the workers, the job can't go out of scope while one of them is still using it
+	std::unique_lock<std::mutex> lock{ m_Mutex };
+	m_DoneCondition.wait(lock, [this]() { return m_AmountBusy == 0; });
+	m_pJob = nullptr;
+}
+
+void ThreadPool::WorkerLoop()
+{
+	uint64_t generation{};
+
+	while (true)
+	{
+		//Sleep until there is new work
+		{
+			std::unique_lock<std::mutex> lock{ m_Mutex };
+			m_StartCondition.wait(lock, [this, generation]() { return m_IsStopping || m_Generation != generation; });
+
+			if (m_IsStopping)
+			{
+				return;
+			}
+
+			generation = m_Generation;
+		}
+
+		RunJobs();
+
+		//Report back
+		{
+			std::lock_guard<std::mutex> lock{ m_Mutex };
+			if (--m_AmountBusy == 0)
+			{
+				m_DoneCondition.notify_one();
+			}
+		}
+	}
+}
+
+void ThreadPool::RunJobs()
+{
+	//Grab job indices until all of them are taken
+	for (uint32_t job{ m_NextJob++ }; job < m_AmountJobs; job = m_NextJob++)
+	{
+		(*m_pJob)(job);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <atomic>
+
+//=== ThreadPool class ===//
+class ThreadPool final
+{
+public:
+	//=== Constructor ===//
+	//The calling thread also works on the jobs, so only amountThreads - 1 threads get started
+	ThreadPool(uint32_t amountThreads = std::thread::hardware_concurrency());
+
+	//=== Rule of five ===//
+	~ThreadPool();
+	ThreadPool(const ThreadPool& threadPool) = delete;
+	ThreadPool(ThreadPool&& threadPool) = delete;
+	ThreadPool& operator=(const ThreadPool& threadPool) = delete;
+	ThreadPool& operator=(ThreadPool&& threadPool) = delete;
+
+	//=== Functions ===//
+	uint32_t GetAmountThreads() const { return uint32_t(m_Threads.size()) + 1; }
+
+	//Runs job(0) ... job(amountJobs - 1) spread over all threads and returns when all of them are done (not reentrant)
+	void ParallelFor(uint32_t amountJobs, const std::function<void(uint32_t)>& job);
+
+private:
+	//=== Functions ===//
+	void WorkerLoop();
+	void RunJobs();
+
+	//=== Variables ===//
+	std::vector<std::thread> m_Threads;
+
+	std::mutex m_Mutex;
+	std::condition_variable m_StartCondition;
+	std::condition_variable m_DoneCondition;
+
+	const std::function<void(uint32_t)>* m_pJob;
+	uint32_t m_AmountJobs;
+	std::atomic<uint32_t> m_NextJob;
+
+	uint32_t m_AmountBusy;
+	uint64_t m_Generation;
+	bool m_IsStopping;
+};
\ No newline at end of file
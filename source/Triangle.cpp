@@ -5,272 +5,238 @@
 #include "Mesh.h"
 
 //=== Constructor ===//
-Triangle::Triangle(const Vertex& vertex0, const Vertex& vertex1, const Vertex& vertex2)
-	: m_OriginalVertices{ vertex0, vertex1, vertex2 }
-	, m_Vertices{ vertex0, vertex1, vertex2 }
-	, m_CurrentAngle{}
+Triangle::Triangle(const VertexStreams& streams, uint32_t index0, uint32_t index1, uint32_t index2)
+	: m_pStreams{ &streams }
+	, m_Indices{ index0, index1, index2 }
 {
 }
 
-//=== Functions ===//
-void Triangle::ModelToNDC(const Elite::FMatrix4& cameraToWorld, float fovAngle, uint32_t width, uint32_t height)
+//=== Helpers ===//
+namespace
 {
-	//Calculate aspect ratio for camera view
-	float aspectRatio{ float(width) / float(height) }, nearPlane{ 0.1f }, farPlane{ 100.f };
-
-	//Matrices
-	const Elite::FMatrix4 viewMatrix{ Elite::Inverse(cameraToWorld) };
-	const Elite::FMatrix4 projectionMatrix{ 1 / (aspectRatio * fovAngle),	0,				0,						0,
-											0,								1 / fovAngle,	0,						0,
-											0,								0,				-farPlane / (farPlane - nearPlane),	-(farPlane * nearPlane) / (farPlane - nearPlane),
-											0,								0,				-1,						0 };
+	//A clipped vertex can't sit exactly on the near plane, depth is interpolated through 1 / z
+	const float g_NearPlaneEpsilon{ 1e-5f };
 
-	const Elite::FMatrix4 viewProjectionMatrix{ projectionMatrix * viewMatrix };
-
-	for (Vertex& vertex : m_Vertices)
+	//Signed distance to a clip plane in clip space, >= 0 is inside
+	float PlaneDistance(uint32_t plane, const Elite::FPoint4& p, float guardBandX, float guardBandY)
 	{
-		//Make local value to hold the position of the vertex that will be transformed
-		Elite::FPoint4 pos{ vertex.position };
-
-		//Transform all vertices from world space to camera space (view space) by multiplying them with the inverse of the camera matrix
-		pos = viewProjectionMatrix * pos;
-
-		//Transform all vertices from view space to NDC coordinates (projection space) => (perspective divide)
-		pos.x /= pos.w;
-		pos.y /= pos.w;
-		pos.z /= pos.w;
-
-		//Give the transformed variables of the vertex back
-		vertex.position = pos;
+		switch (plane)
+		{
+		case Triangle::Near:
+			return p.z - g_NearPlaneEpsilon * p.w;
+		case Triangle::Far:
+			return p.w - p.z;
+		case Triangle::Left:
+			return p.x + guardBandX * p.w;
+		case Triangle::Right:
+			return guardBandX * p.w - p.x;
+		case Triangle::Bottom:
+			return p.y + guardBandY * p.w;
+		default:
+			return guardBandY * p.w - p.y;
+		}
 	}
-}
-
-void Triangle::ModelToWorld(const Elite::FPoint3& cameraPos, const Elite::FMatrix4& worldMatrix)
-{
-	//Keep hold of original vertices
-	m_Vertices = m_OriginalVertices;
-
-	//Matrices
-	const Elite::FMatrix4 worldMatrix4{ worldMatrix };
-	const Elite::FMatrix3 worldMatrix3{ worldMatrix4 };
 
-	for (Vertex& vertex : m_Vertices)
+	uint32_t Outcode(const Elite::FPoint4& p, float guardBandX, float guardBandY)
 	{
-		//Make local value to hold the position of the vertex that will be transformed
-		Elite::FPoint4 pos{ vertex.position };
-		Elite::FVector3 normal{ vertex.normal };
-		Elite::FVector3 tangent{ vertex.tangent };
-		Elite::FVector3 viewDir{ vertex.viewDirection };
-
-		//Transform the normal and tangent to world space
-		pos = worldMatrix4 * pos;
-		normal = Elite::GetNormalized(worldMatrix3 * normal);
-		tangent = Elite::GetNormalized(worldMatrix3 * tangent);
-		viewDir = Elite::GetNormalized(pos.xyz - cameraPos);
-
-		//Give the transformed variables of the vertex back
-		vertex.position = pos;
-		vertex.normal = normal;
-		vertex.tangent = tangent;
-		vertex.viewDirection = viewDir;
+		uint32_t outcode{};
+		if (p.z < 0.f) outcode |= Triangle::Near;
+		if (p.z > p.w) outcode |= Triangle::Far;
+		if (p.x < -guardBandX * p.w) outcode |= Triangle::Left;
+		if (p.x > guardBandX * p.w) outcode |= Triangle::Right;
+		if (p.y < -guardBandY * p.w) outcode |= Triangle::Bottom;
+		if (p.y > guardBandY * p.w) outcode |= Triangle::Top;
+		return outcode;
 	}
-}
 
-bool Triangle::FrustumCulling()
-{
-	for (Vertex& vertex : m_Vertices)
+	//Attributes are linear in clip space, so the clipped vertex is a plain lerp
+	struct ClipVertex
 	{
-		//Check if vertex isn't in screen
-		if (vertex.position.x < -1.0f || vertex.position.x > 1.0f ||
-			vertex.position.y < -1.0f || vertex.position.y > 1.0f ||
-			vertex.position.z < 0.0f || vertex.position.z > 1.0f)
-		{
-			return true;
-		}
-	}
-
-	return false;
-}
+		Elite::FPoint4 clipPosition;
+		VertexAttributes attributes;
+		Elite::RGBColor color;
+	};
 
-void Triangle::NDCToScreen(uint32_t width, uint32_t height)
-{
-	for (Vertex& vertex : m_Vertices)
+	ClipVertex Lerp(const ClipVertex& v0, const ClipVertex& v1, float t)
 	{
-		//Make local value to hold the position of the vertex that will be transformed
-		Elite::FPoint4 pos{ vertex.position };
-
-		//Transfrom all vertices from projection space to screen space
-		pos.x = ((pos.x + 1.f) / 2.f) * width;
-		pos.y = ((1.f - pos.y) / 2.f) * height;
-
-		//Give the transformed variables of the vertex back
-		vertex.position = pos;
+		ClipVertex result{};
+		result.clipPosition = Elite::FPoint4{ v0.clipPosition.x + (v1.clipPosition.x - v0.clipPosition.x) * t, v0.clipPosition.y + (v1.clipPosition.y - v0.clipPosition.y) * t,
+			v0.clipPosition.z + (v1.clipPosition.z - v0.clipPosition.z) * t, v0.clipPosition.w + (v1.clipPosition.w - v0.clipPosition.w) * t };
+		result.color = v0.color + (v1.color - v0.color) * t;
+		result.attributes.uv = v0.attributes.uv + (v1.attributes.uv - v0.attributes.uv) * t;
+		result.attributes.normal = v0.attributes.normal + (v1.attributes.normal - v0.attributes.normal) * t;
+		result.attributes.tangent = v0.attributes.tangent + (v1.attributes.tangent - v0.attributes.tangent) * t;
+		result.attributes.tangentSign = v0.attributes.tangentSign;
+		result.attributes.viewDirection = v0.attributes.viewDirection + (v1.attributes.viewDirection - v0.attributes.viewDirection) * t;
+		return result;
 	}
 }
 
-std::vector<Elite::FPoint2> Triangle::GetBoundingBox(float width, float height)
+//=== Functions ===//
+bool Triangle::FrustumCulling() const
 {
-	//Initialize bounding box
-	std::vector<Elite::FPoint2> boudingBox;
-
-	//Make vector for std::min_element (could also use std::min without vector)
-	std::vector<float> xPos{ m_Vertices[0].position.x, m_Vertices[1].position.x, m_Vertices[2].position.x };
-	std::vector<float> yPos{ m_Vertices[0].position.y, m_Vertices[1].position.y, m_Vertices[2].position.y };
-
-	//Look for most top left point
-	Elite::FPoint2 topLeft{};
-	topLeft.x = std::clamp(*std::min_element(xPos.begin(), xPos.end()) - 1.f, 0.0f, width);
-	topLeft.y = std::clamp(*std::min_element(yPos.begin(), yPos.end()) - 1.f, 0.0f, height);
-
-	//Look for most bottom right point
-	Elite::FPoint2 bottomRight{};
-	bottomRight.x = std::clamp(*std::max_element(xPos.begin(), xPos.end()) + 1.f, 0.0f, width);
-	bottomRight.y = std::clamp(*std::max_element(yPos.begin(), yPos.end()) + 1.f, 0.0f, height);
-
-	//Push points to vector
-	boudingBox.push_back(topLeft);
-	boudingBox.push_back(bottomRight);
+	//Outcodes against the real frustum (guard band of 1), a triangle is only invisible for sure if all vertices are outside the same plane
+	return (Outcode(GetClipPosition(0), 1.f, 1.f) & Outcode(GetClipPosition(1), 1.f, 1.f) & Outcode(GetClipPosition(2), 1.f, 1.f)) != 0;
+}
 
-	return boudingBox;
+uint32_t Triangle::GetClipPlanes(const Elite::FrameConstants& constants) const
+{
+	//Crossing the frustum sides is fine as long as the triangle stays in the guard band, the rasterizer only walks the screen part
+	return Outcode(GetClipPosition(0), constants.guardBandX, constants.guardBandY) |
+		Outcode(GetClipPosition(1), constants.guardBandX, constants.guardBandY) |
+		Outcode(GetClipPosition(2), constants.guardBandX, constants.guardBandY);
 }
 
-bool Triangle::PixelInTriangle(const Elite::FPoint2& pixel, float& weight0, float& weight1, float& weight2, CullMode& cullmode)
+uint32_t Triangle::Clip(uint32_t clipPlanes, const Elite::FrameConstants& constants, VertexStreams& streams) const
 {
-	//Initialize area
-	float dot{};
-	const float totalArea{ Elite::Cross((m_Vertices[0].position - m_Vertices[2].position).xy, (m_Vertices[0].position - m_Vertices[1].position).xy) };
-	Elite::FVector2 pointToSide{};
-
-	//Calculate first edge and look if the pixel is on the good side
-	const Elite::FVector2 edgeA = m_Vertices[1].position.xy - m_Vertices[0].position.xy;
-	pointToSide = pixel - m_Vertices[0].position.xy;
-	float signedAreaA = Elite::Cross(pointToSide, edgeA);
-	weight2 = signedAreaA / totalArea;
-
-	//Calculate second edge and look if the pixel is on the good side
-	const Elite::FVector2 edgeB = m_Vertices[2].position.xy - m_Vertices[1].position.xy;
-	pointToSide = pixel - m_Vertices[1].position.xy;
-	float signedAreaB = Elite::Cross(pointToSide, edgeB);
-	weight0 = signedAreaB / totalArea;
-
-	//Calculate third edge and look if the pixel is on the good side
-	const Elite::FVector2 edgeC = m_Vertices[0].position.xy - m_Vertices[2].position.xy;
-	pointToSide = pixel - m_Vertices[2].position.xy;
-	float signedAreaC = Elite::Cross(pointToSide, edgeC);
-	weight1 = signedAreaC / totalArea;
-
-	//Cullcheck -> if pixel is not inside a triangle
-	switch (cullmode)
+	//Every plane adds at most one vertex to the polygon
+	const uint32_t maxVertices{ 3 + 6 };
+	ClipVertex polygons[2][maxVertices]{};
+	uint32_t amountVertices{ 3 };
+	for (int i{}; i < 3; ++i)
 	{
-	case CullMode::BackFaceCulling:
+		polygons[0][i] = ClipVertex{ GetClipPosition(i), GetAttributes(i), m_pStreams->colors.empty() ? Elite::RGBColor{} : m_pStreams->colors[m_Indices[i]] };
+	}
 
-		if (signedAreaA < 0)
+	//Sutherland-Hodgman, near first so every vertex after it has w > 0
+	int current{};
+	const uint32_t planes[6]{ Near, Far, Left, Right, Bottom, Top };
+	for (uint32_t plane : planes)
+	{
+		if (!(clipPlanes & plane))
 		{
-			return false;
+			continue;
 		}
 
-		if (signedAreaB < 0)
-		{
-			return false;
-		}
+		const ClipVertex* pInput{ polygons[current] };
+		ClipVertex* pOutput{ polygons[1 - current] };
+		uint32_t amountOutput{};
 
-		if (signedAreaC < 0)
+		for (uint32_t i{}; i < amountVertices; ++i)
 		{
-			return false;
-		}
-
-		break;
+			const ClipVertex& v0{ pInput[i] };
+			const ClipVertex& v1{ pInput[(i + 1) % amountVertices] };
+			const float distance0{ PlaneDistance(plane, v0.clipPosition, constants.guardBandX, constants.guardBandY) };
+			const float distance1{ PlaneDistance(plane, v1.clipPosition, constants.guardBandX, constants.guardBandY) };
 
-	case CullMode::FrontFaceCulling:
-
-		if (signedAreaA > 0)
-		{
-			return false;
+			if (distance0 >= 0.f)
+			{
+				pOutput[amountOutput++] = v0;
+			}
+			if ((distance0 >= 0.f) != (distance1 >= 0.f))
+			{
+				pOutput[amountOutput++] = Lerp(v0, v1, distance0 / (distance0 - distance1));
+			}
 		}
 
-		if (signedAreaB > 0)
+		amountVertices = amountOutput;
+		current = 1 - current;
+		if (amountVertices < 3)
 		{
-			return false;
+			return 0;
 		}
+	}
 
-		if (signedAreaC > 0)
-		{
-			return false;
-		}
+	//Append in screen space, the polygon stays convex and keeps the winding of the triangle
+	for (uint32_t i{}; i < amountVertices; ++i)
+	{
+		const ClipVertex& vertex{ polygons[current][i] };
+		streams.clipPositions.push_back(vertex.clipPosition);
+		streams.screenPositions.push_back(constants.ClipToScreen(vertex.clipPosition));
+		streams.attributes.push_back(vertex.attributes);
+		streams.colors.push_back(vertex.color);
+	}
 
-		break;
+	return amountVertices;
+}
 
-	case CullMode::NoCulling:
+bool Triangle::Setup(TriangleSetup& setup, CullMode cullmode, uint32_t width, uint32_t height) const
+{
+	const Elite::FPoint4& v0{ GetScreenPosition(0) };
+	const Elite::FPoint4& v1{ GetScreenPosition(1) };
+	const Elite::FPoint4& v2{ GetScreenPosition(2) };
+
+	//Snap to 28.4 fixed point
+	const float scale{ float(EdgeFunction::subPixelScale) };
+	const int32_t x[3]{ int32_t(lroundf(v0.x * scale)), int32_t(lroundf(v1.x * scale)), int32_t(lroundf(v2.x * scale)) };
+	const int32_t y[3]{ int32_t(lroundf(v0.y * scale)), int32_t(lroundf(v1.y * scale)), int32_t(lroundf(v2.y * scale)) };
+
+	//Signed area decides the winding of the triangle on screen (8 fractional bits, exact), zero area is degenerate
+	const int64_t totalArea{ int64_t(x[0] - x[2]) * (y[0] - y[1]) - int64_t(y[0] - y[2]) * (x[0] - x[1]) };
+	if (totalArea == 0)
+	{
+		return false;
+	}
 
-		Elite::FVector3 normal = Elite::GetNormalized(Elite::Cross(Elite::FVector3(m_Vertices[1].position - m_Vertices[0].position), Elite::FVector3(m_Vertices[2].position - m_Vertices[0].position)));
-		Elite::FVector3 viewdirection = Elite::GetNormalized(m_Vertices[0].viewDirection * weight0 + m_Vertices[1].viewDirection * weight1 + m_Vertices[2].viewDirection * weight2);
-		dot = Elite::Dot(normal, viewdirection);
+	//Cullcheck -> a wrongly wound triangle can't contain a single pixel
+	if ((cullmode == CullMode::BackFaceCulling && totalArea < 0) ||
+		(cullmode == CullMode::FrontFaceCulling && totalArea > 0))
+	{
+		return false;
+	}
 
-		if (dot > 0)
-		{
-			if (signedAreaA < 0)
-			{
-				return false;
-			}
-		}
-		else
-		{
-			if (signedAreaA > 0)
-			{
-				return false;
-			}
-		}
+	//Bounding box of the pixel centers inside the snapped triangle, clamped to the screen
+	const int32_t half{ EdgeFunction::subPixelScale / 2 };
+	const int32_t minX{ std::min({ x[0], x[1], x[2] }) };
+	const int32_t minY{ std::min({ y[0], y[1], y[2] }) };
+	const int32_t maxX{ std::max({ x[0], x[1], x[2] }) };
+	const int32_t maxY{ std::max({ y[0], y[1], y[2] }) };
 
-		if (dot > 0)
-		{
-			if (signedAreaB < 0)
-			{
-				return false;
-			}
-		}
-		else
-		{
-			if (signedAreaB > 0)
-			{
-				return false;
-			}
-		}
+	setup.minX = uint32_t(std::clamp((minX - half + EdgeFunction::subPixelScale - 1) >> EdgeFunction::subPixelBits, 0, int32_t(width)));
+	setup.minY = uint32_t(std::clamp((minY - half + EdgeFunction::subPixelScale - 1) >> EdgeFunction::subPixelBits, 0, int32_t(height)));
+	setup.maxX = uint32_t(std::clamp(((maxX - half) >> EdgeFunction::subPixelBits) + 1, 0, int32_t(width)));
+	setup.maxY = uint32_t(std::clamp(((maxY - half) >> EdgeFunction::subPixelBits) + 1, 0, int32_t(height)));
 
-		if (dot > 0)
-		{
-			if (signedAreaC < 0)
-			{
-				return false;
-			}
-		}
-		else
+	//Sub-pixel triangles (or triangles only touching the screen border) don't contain a single pixel center
+	if (setup.minX >= setup.maxX || setup.minY >= setup.maxY)
+	{
+		return false;
+	}
+
+	//Edge functions (opposite vertex 0, 1 and 2) => E(p) = Cross(p - start, end - start), flipped for negative area so inside is always >= 0
+	const int32_t orientation{ totalArea > 0 ? 1 : -1 };
+	const int starts[3]{ 1, 2, 0 };
+	const int ends[3]{ 2, 0, 1 };
+	for (int i{}; i < 3; ++i)
+	{
+		EdgeFunction& edge{ setup.edges[i] };
+		edge.a = (y[ends[i]] - y[starts[i]]) * orientation;
+		edge.b = (x[starts[i]] - x[ends[i]]) * orientation;
+		edge.c = -(int64_t(x[starts[i]]) * edge.a + int64_t(y[starts[i]]) * edge.b);
+
+		//Top-left rule, a pixel center exactly on an edge only belongs to the triangle if it's a top or left edge (shared edges are drawn once)
+		const bool isTopLeft{ edge.a > 0 || (edge.a == 0 && edge.b > 0) };
+		if (!isTopLeft)
 		{
-			if (signedAreaC > 0)
-			{
-				return false;
-			}
+			edge.c -= 1;
 		}
+	}
+	setup.invArea = 1.f / float(totalArea * orientation);
 
-		break;
-
-	default:
-		break;
+	for (int i{}; i < 3; ++i)
+	{
+		setup.invZ[i] = 1.f / GetScreenPosition(i).z;
+		setup.invW[i] = 1.f / GetScreenPosition(i).w;
 	}
+	setup.minZ = std::min({ v0.z, v1.z, v2.z });
 
-	//All tests succeeded, the pixel is in the triangle
 	return true;
 }
 
-bool Triangle::Depth(float& depthBufferPixel, float& wInterpolated, const float weight0, const float weight1, const float weight2)
+bool Triangle::Depth(float& depthBufferPixel, float& wInterpolated, const float weight0, const float weight1, const float weight2) const
 {
+	const Elite::FPoint4& position0{ GetScreenPosition(0) };
+	const Elite::FPoint4& position1{ GetScreenPosition(1) };
+	const Elite::FPoint4& position2{ GetScreenPosition(2) };
+
 	//Initialize interpolated depth
-	float zInterpolated{ 1 / (((1 / m_Vertices[0].position.z) * weight0) +
-								((1 / m_Vertices[1].position.z) * weight1) +
-								((1 / m_Vertices[2].position.z) * weight2)) };
+	float zInterpolated{ 1 / (((1 / position0.z) * weight0) +
+								((1 / position1.z) * weight1) +
+								((1 / position2.z) * weight2)) };
 
-	wInterpolated = { 1 / (((1 / m_Vertices[0].position.w) * weight0) +
-							((1 / m_Vertices[1].position.w) * weight1) +
-							((1 / m_Vertices[2].position.w) * weight2)) };
+	wInterpolated = { 1 / (((1 / position0.w) * weight0) +
+							((1 / position1.w) * weight1) +
+							((1 / position2.w) * weight2)) };
 
 	float zBuffer{ zInterpolated };
 
@@ -284,29 +250,69 @@ bool Triangle::Depth(float& depthBufferPixel, float& wInterpolated, const float
 	return false;
 }
 
+void Triangle::UVDerivatives(const TriangleSetup& setup, uint32_t c, uint32_t r, Elite::FVector2& uvDdx, Elite::FVector2& uvDdy) const
+{
+	const Elite::FVector2& uv0{ GetAttributes(0).uv };
+	const Elite::FVector2& uv1{ GetAttributes(1).uv };
+	const Elite::FVector2& uv2{ GetAttributes(2).uv };
+
+	//Perspective correct uv at the center of any pixel, straight from the edge functions
+	//False when the pixel is too far outside the triangle to extrapolate (1/w interpolates to zero, negative or overflows)
+	const auto uvAtPixel = [&](uint32_t x, uint32_t y, Elite::FVector2& uv)
+	{
+		const int32_t centerX{ int32_t(x) * EdgeFunction::subPixelScale + EdgeFunction::subPixelScale / 2 };
+		const int32_t centerY{ int32_t(y) * EdgeFunction::subPixelScale + EdgeFunction::subPixelScale / 2 };
+		const float weight0{ float(setup.edges[0].Evaluate(centerX, centerY)) * setup.invArea * setup.invW[0] };
+		const float weight1{ float(setup.edges[1].Evaluate(centerX, centerY)) * setup.invArea * setup.invW[1] };
+		const float weight2{ float(setup.edges[2].Evaluate(centerX, centerY)) * setup.invArea * setup.invW[2] };
+
+		const float totalWeight{ weight0 + weight1 + weight2 };
+		if (!std::isfinite(totalWeight) || totalWeight <= 0.f)
+		{
+			return false;
+		}
+		uv = (uv0 * weight0 + uv1 * weight1 + uv2 * weight2) / totalWeight;
+		return std::isfinite(uv.x) && std::isfinite(uv.y);
+	};
+
+	//Top left pixel of the quad and its right and bottom neighbours, zero derivatives (sharpest mip, one tap) when any of them can't be extrapolated
+	const uint32_t quadX{ c & ~1u }, quadY{ r & ~1u };
+	Elite::FVector2 uvQuad{}, uvRight{}, uvBottom{};
+	if (!uvAtPixel(quadX, quadY, uvQuad) || !uvAtPixel(quadX + 1, quadY, uvRight) || !uvAtPixel(quadX, quadY + 1, uvBottom))
+	{
+		uvDdx = Elite::FVector2{};
+		uvDdy = Elite::FVector2{};
+		return;
+	}
+	uvDdx = uvRight - uvQuad;
+	uvDdy = uvBottom - uvQuad;
+}
+
 void Triangle::AttributeInterpolation(Triangle* pTriangle, const float wInterpolated, const float weight0, const float weight1, const float weight2, Elite::FVector2& uvInterpolated,
-	Elite::FVector3& normalInterpolated, Elite::FVector3& tangentInterpolated, Elite::FVector3& viewDirectionInterpolated, Elite::RGBColor& colorInterpolated)
+	Elite::FVector3& normalInterpolated, Elite::FVector3& tangentInterpolated, Elite::FVector3& viewDirectionInterpolated, Elite::RGBColor& colorInterpolated) const
 {
-	//Calculate interpolated attributes
-	uvInterpolated = (((m_Vertices[0].uv / m_Vertices[0].position.w) * weight0) +
-		((m_Vertices[1].uv / m_Vertices[1].position.w) * weight1) +
-		((m_Vertices[2].uv / m_Vertices[2].position.w) * weight2)) * wInterpolated;
+	const VertexAttributes& vertex0{ GetAttributes(0) };
+	const VertexAttributes& vertex1{ GetAttributes(1) };
+	const VertexAttributes& vertex2{ GetAttributes(2) };
+
+	//Perspective correction, same 1 / w for every attribute
+	const float invW0{ weight0 / GetScreenPosition(0).w };
+	const float invW1{ weight1 / GetScreenPosition(1).w };
+	const float invW2{ weight2 / GetScreenPosition(2).w };
 
+	//Calculate interpolated attributes
+	uvInterpolated = ((vertex0.uv * invW0) + (vertex1.uv * invW1) + (vertex2.uv * invW2)) * wInterpolated;
 
-	normalInterpolated = (((m_Vertices[0].normal / m_Vertices[0].position.w) * weight0) +
-		((m_Vertices[1].normal / m_Vertices[1].position.w) * weight1) +
-		((m_Vertices[2].normal / m_Vertices[2].position.w) * weight2)) * wInterpolated;
+	normalInterpolated = ((vertex0.normal * invW0) + (vertex1.normal * invW1) + (vertex2.normal * invW2)) * wInterpolated;
 	Elite::Normalize(normalInterpolated);
 
-	tangentInterpolated = (((m_Vertices[0].tangent / m_Vertices[0].position.w) * weight0) +
-		((m_Vertices[1].tangent / m_Vertices[1].position.w) * weight1) +
-		((m_Vertices[2].tangent / m_Vertices[2].position.w) * weight2)) * wInterpolated;
+	tangentInterpolated = ((vertex0.tangent * invW0) + (vertex1.tangent * invW1) + (vertex2.tangent * invW2)) * wInterpolated;
 	Elite::Normalize(tangentInterpolated);
 
-	viewDirectionInterpolated = (((m_Vertices[0].viewDirection / m_Vertices[0].position.w) * weight0) +
-		((m_Vertices[1].viewDirection / m_Vertices[1].position.w) * weight1) +
-		((m_Vertices[2].viewDirection / m_Vertices[2].position.w) * weight2)) * wInterpolated;
+	viewDirectionInterpolated = ((vertex0.viewDirection * invW0) + (vertex1.viewDirection * invW1) + (vertex2.viewDirection * invW2)) * wInterpolated;
 	Elite::Normalize(viewDirectionInterpolated);
 
-	colorInterpolated = m_Vertices[0].color * weight0 + m_Vertices[1].color * weight1 + m_Vertices[2].color * weight2;
+	//Meshes without vertex colors have no color stream, black like their vertices
+	const std::vector<Elite::RGBColor>& colors{ m_pStreams->colors };
+	colorInterpolated = colors.empty() ? Elite::RGBColor{} : colors[m_Indices[0]] * weight0 + colors[m_Indices[1]] * weight1 + colors[m_Indices[2]] * weight2;
 }
\ No newline at end of file
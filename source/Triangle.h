@@ -2,14 +2,71 @@
 
 #include <vector>
 
-#include "Vertex.h"
+#include "VertexStreams.h"
+#include "FrameConstants.h"
+
+class Triangle;
+
+//=== EdgeFunction struct ===//
+//Screen positions are snapped to 28.4 fixed point (1/16th of a pixel), so coverage is exact and deterministic integer math.
+//Values at pixels fit in 32 bits as long as the positions stay inside the guard band (see FrameConstants)
+struct EdgeFunction
+{
+	//=== Functions ===//
+	//x and y in 28.4, the result has 8 fractional bits
+	int64_t Evaluate(int32_t x, int32_t y) const { return int64_t(a) * x + int64_t(b) * y + c; }
+
+	//=== Variables ===//
+	static const int32_t subPixelBits{ 4 };
+	static const int32_t subPixelScale{ 1 << subPixelBits };
+
+	int32_t a; //Step per sub-pixel column
+	int32_t b; //Step per sub-pixel row
+	int64_t c; //Includes the top-left fill rule bias
+};
+
+//=== TriangleSetup struct ===//
+struct TriangleSetup
+{
+	//=== Variables ===//
+	Triangle* pTriangle;
+
+	//Edge functions are oriented so inside is >= 0, scaling them by the inverse area gives the barycentric weights
+	EdgeFunction edges[3];
+	float invArea;
+
+	//Reciprocal depth and w of the vertices, for perspective correct interpolation
+	float invZ[3];
+	float invW[3];
+
+	//Closest depth of the triangle, nothing it covers can be in front of this (hierarchical Z rejection)
+	float minZ;
+
+	//Pixel bounds to walk, max is exclusive
+	uint32_t minX, minY;
+	uint32_t maxX, maxY;
+};
+
+//=== VisibilityPixel struct ===//
+//One per pixel in visibility buffer mode, enough to reconstruct every attribute in the shading pass
+struct VisibilityPixel
+{
+	//=== Variables ===//
+	static const uint32_t invalidIndex{ UINT32_MAX };
+
+	uint32_t setupIndex; //Triangle ID, index in the triangle setups of this frame
+	float weight0;
+	float weight1; //weight2 = 1 - weight0 - weight1
+	float wInterpolated;
+};
 
 //=== Triangle class ===//
 class Triangle final
 {
 public:
 	//=== Constructor ===//
-	Triangle(const Vertex& vertex0, const Vertex& vertex1, const Vertex& vertex2);
+	//Triangles only reference their vertices, the mesh transforms every vertex once per frame
+	Triangle(const VertexStreams& streams, uint32_t index0, uint32_t index1, uint32_t index2);
 
 	//=== Rule of five ===//
 	virtual ~Triangle() = default;
@@ -27,21 +84,41 @@ public:
 		Static,
 	};
 
+	//=== ClipPlane enum ===//
+	//Bits of an outcode, a set bit means outside that plane
+	enum ClipPlane : uint32_t
+	{
+		Near = 1 << 0,
+		Far = 1 << 1,
+		Left = 1 << 2,
+		Right = 1 << 3,
+		Bottom = 1 << 4,
+		Top = 1 << 5,
+	};
+
 	//=== Functions ===//
-	void ModelToNDC(const Elite::FMatrix4& cameraToWorld, float fovAngle, uint32_t width, uint32_t height);
-	void ModelToWorld(const Elite::FPoint3& cameraPos, const Elite::FMatrix4& worldMatrix);
-	bool FrustumCulling();
-	void NDCToScreen(uint32_t width, uint32_t height);
-	std::vector<Elite::FPoint2> GetBoundingBox(float width, float height);
-	bool PixelInTriangle(const Elite::FPoint2& pixel, float& weight0, float& weight1, float& weight2, CullMode& cullmode);
-	bool Depth(float& depthBufferPixel, float& wInterpolated, const float weight0, const float weight1, const float weight2);
+	uint32_t GetIndex(int index) const { return m_Indices[index]; }
+	const Elite::FPoint4& GetClipPosition(int index) const { return m_pStreams->clipPositions[m_Indices[index]]; }
+	const Elite::FPoint4& GetScreenPosition(int index) const { return m_pStreams->screenPositions[m_Indices[index]]; }
+	const VertexAttributes& GetAttributes(int index) const { return m_pStreams->attributes[m_Indices[index]]; }
+
+	//Trivial reject, only when all three vertices are outside the same frustum plane
+	bool FrustumCulling() const;
+	//Planes the triangle crosses and has to be clipped against (near, far and the guard band), 0 when it can be rasterized as is
+	uint32_t GetClipPlanes(const Elite::FrameConstants& constants) const;
+	//Clips against the given planes and appends the resulting convex polygon, returns the amount of vertices appended (0 or >= 3)
+	//Clipped vertices always get a color, so the streams of triangles from meshes with and without colors can be shared
+	uint32_t Clip(uint32_t clipPlanes, const Elite::FrameConstants& constants, VertexStreams& streams) const;
+	//Returns false for zero-area, culled and sub-pixel triangles, they never reach the rasterizer
+	bool Setup(TriangleSetup& setup, CullMode cullmode, uint32_t width, uint32_t height) const;
+	bool Depth(float& depthBufferPixel, float& wInterpolated, const float weight0, const float weight1, const float weight2) const;
+	//Screen space derivatives of uv from the 2x2 pixel quad of (c, r), quad pixels outside the triangle are extrapolated like GPU helper pixels
+	void UVDerivatives(const TriangleSetup& setup, uint32_t c, uint32_t r, Elite::FVector2& uvDdx, Elite::FVector2& uvDdy) const;
 	void AttributeInterpolation(Triangle* pTriangle, const float wInterpolated, const float weight0, const float weight1, const float weight2, Elite::FVector2& uvInterpolated,
-		Elite::FVector3& normalInterpolated, Elite::FVector3& tangentInterpolated, Elite::FVector3& viewDirectionInterpolated, Elite::RGBColor& colorInterpolated);
+		Elite::FVector3& normalInterpolated, Elite::FVector3& tangentInterpolated, Elite::FVector3& viewDirectionInterpolated, Elite::RGBColor& colorInterpolated) const;
 
 private:
 	//=== Variables ===//
-	std::vector<Vertex> m_OriginalVertices;
-	std::vector<Vertex> m_Vertices;
-
-	float m_CurrentAngle;
+	const VertexStreams* m_pStreams;
+	const uint32_t m_Indices[3];
 };
\ No newline at end of file
@@ -7,12 +7,13 @@
 struct Vertex
 {
 	//=== Constructor ===//
-	Vertex(const Elite::FPoint4& position = {}, const Elite::RGBColor& color = {}, const Elite::FVector2& uv = {}, const Elite::FVector3& normal = {}, const Elite::FVector3& tangent = {}, const Elite::FVector3& viewDirection = {})
+	Vertex(const Elite::FPoint4& position = {}, const Elite::RGBColor& color = {}, const Elite::FVector2& uv = {}, const Elite::FVector3& normal = {}, const Elite::FVector3& tangent = {}, const Elite::FVector3& viewDirection = {}, float tangentSign = 1.f)
 		: position{ position }
 		, color{ color }
 		, uv{ uv }
 		, normal{ normal }
 		, tangent{ tangent }
+		, tangentSign{ tangentSign }
 		, viewDirection{ viewDirection }
 	{
 	}
@@ -23,5 +24,6 @@ struct Vertex
 	Elite::FVector2 uv;
 	Elite::FVector3 normal;
 	Elite::FVector3 tangent;
+	float tangentSign; //Handedness, bitangent = Cross(tangent, normal) * tangentSign
 	Elite::FVector3 viewDirection;
 };
\ No newline at end of file
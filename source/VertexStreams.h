@@ -0,0 +1,45 @@
+#pragma once
+
+#include <vector>
+
+#include "EMath.h"
+#include "ERGBColor.h"
+
+//=== VertexAttributes struct ===//
+//Shading part of a post-transform vertex, the stages before the rasterizer never read it
+struct VertexAttributes
+{
+	Elite::FVector2 uv;
+	Elite::FVector3 normal;
+	Elite::FVector3 tangent;
+	float tangentSign; //Handedness, bitangent = Cross(tangent, normal) * tangentSign
+	Elite::FVector3 viewDirection;
+};
+
+//=== VertexStreams struct ===//
+//Post-transform vertices, one stream per kind of data (SoA) so culling, clipping and setup only walk the positions
+struct VertexStreams
+{
+	//=== Functions ===//
+	void Resize(size_t amountVertices, bool hasColors)
+	{
+		clipPositions.resize(amountVertices);
+		screenPositions.resize(amountVertices);
+		attributes.resize(amountVertices);
+		colors.resize(hasColors ? amountVertices : 0);
+	}
+
+	void Clear()
+	{
+		clipPositions.clear();
+		screenPositions.clear();
+		attributes.clear();
+		colors.clear();
+	}
+
+	//=== Variables ===//
+	std::vector<Elite::FPoint4> clipPositions; //Before the perspective divide, needed for culling and clipping
+	std::vector<Elite::FPoint4> screenPositions; //x and y in pixels, z after the divide, w kept for perspective correct interpolation
+	std::vector<VertexAttributes> attributes; //Only up to date for vertices of triangles that survived culling
+	std::vector<Elite::RGBColor> colors; //Optional, empty when all vertex colors are black
+};
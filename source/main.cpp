@@ -11,23 +11,29 @@
 #include <iostream>
 
 //Project includes
+#include "SDL_image.h"
 #include "ETimer.h"
 #include "ERenderer.h"
+#include "SelfTests.h"
 
 void ShutDown(SDL_Window* pWindow)
 {
 	SDL_DestroyWindow(pWindow);
+	IMG_Quit();
 	SDL_Quit();
 }
 
 int main(int argc, char* args[])
 {
-	//Unreferenced parameters
-	(void)argc;
-	(void)args;
+	//Deterministic checks only, no window needed
+	if (argc > 1 && std::string(args[1]) == "--selftest")
+	{
+		return Elite::RunSelfTests() ? 0 : 1;
+	}
 
 	//Create window + surfaces
 	SDL_Init(SDL_INIT_VIDEO);
+	IMG_Init(IMG_INIT_PNG); //Up front, textures get decoded on several threads at once
 
 	const uint32_t width = 640;
 	const uint32_t height = 480;
@@ -74,6 +80,12 @@ int main(int argc, char* args[])
 					e.key.keysym.scancode == SDL_SCANCODE_F ||
 					e.key.keysym.scancode == SDL_SCANCODE_T ||
 					e.key.keysym.scancode == SDL_SCANCODE_N ||
+					e.key.keysym.scancode == SDL_SCANCODE_K ||
+					e.key.keysym.scancode == SDL_SCANCODE_V ||
+					e.key.keysym.scancode == SDL_SCANCODE_H ||
+					e.key.keysym.scancode == SDL_SCANCODE_M ||
+					e.key.keysym.scancode == SDL_SCANCODE_L ||
+					e.key.keysym.scancode == SDL_SCANCODE_B ||
 					e.key.keysym.scancode == SDL_SCANCODE_Z) pRenderer->InfoKeys(e.key.keysym.scancode);
 
 				if (e.key.keysym.scancode == SDL_SCANCODE_O)